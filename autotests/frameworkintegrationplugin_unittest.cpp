@@ -0,0 +1,113 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "frameworkintegrationplugin.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+static void prepareEnvironment()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+Q_COREAPP_STARTUP_FUNCTION(prepareEnvironment)
+
+class FrameworkIntegrationPlugin_UnitTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testImmediateReparse()
+    {
+        KFrameworkIntegrationPlugin plugin;
+        plugin.setLazyReparse(false);
+        QSignalSpy spy(&plugin, &KFrameworkIntegrationPlugin::configurationReparsed);
+        plugin.reparseConfiguration();
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(!plugin.isConfigurationStale());
+    }
+
+    void testReparseOnAccess()
+    {
+        const QString configName = KSharedConfig::openConfig()->name();
+        KConfigGroup(KSharedConfig::openConfig(), QStringLiteral("Notification Messages")).deleteEntry("testMessage");
+        KSharedConfig::openConfig()->sync();
+
+        KFrameworkIntegrationPlugin plugin;
+        plugin.setLazyReparse(true);
+        plugin.setMaxReparseDelay(60000);
+        QSignalSpy spy(&plugin, &KFrameworkIntegrationPlugin::configurationReparsed);
+        auto storage = plugin.property(KMESSAGEBOXDONTASKAGAIN_PROPERTY).value<KMessageBoxDontAskAgainInterface *>();
+        QVERIFY(storage);
+        QVERIFY(storage->shouldBeShownContinue(QStringLiteral("testMessage")));
+
+        // Another process changes the setting and announces it
+        {
+            KConfig other(configName);
+            KConfigGroup(&other, QStringLiteral("Notification Messages")).writeEntry("testMessage", false);
+        }
+        plugin.reparseConfiguration();
+        plugin.reparseConfiguration();
+        QVERIFY(plugin.isConfigurationStale());
+        QCOMPARE(spy.count(), 0);
+
+        // Reading the setting doesn't wait for the delay
+        QVERIFY(!storage->shouldBeShownContinue(QStringLiteral("testMessage")));
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(!plugin.isConfigurationStale());
+    }
+
+    // Simulates a settings change announced to many applications at once
+    void testStaggeredReparse()
+    {
+        const int instances = 200;
+        const int maxDelay = 500;
+
+        std::vector<std::unique_ptr<KFrameworkIntegrationPlugin>> plugins;
+        QList<qint64> reparseTimes;
+        QElapsedTimer timer;
+        for (int i = 0; i < instances; ++i) {
+            plugins.push_back(std::make_unique<KFrameworkIntegrationPlugin>());
+            plugins.back()->setLazyReparse(true);
+            plugins.back()->setMaxReparseDelay(maxDelay);
+            connect(plugins.back().get(), &KFrameworkIntegrationPlugin::configurationReparsed, this, [&reparseTimes, &timer]() {
+                reparseTimes << timer.elapsed();
+            });
+        }
+
+        timer.start();
+        for (const auto &plugin : plugins) {
+            plugin->reparseConfiguration();
+        }
+        // Nobody reparsed synchronously
+        QVERIFY(reparseTimes.isEmpty());
+
+        QTRY_COMPARE_WITH_TIMEOUT(reparseTimes.size(), instances, maxDelay * 10);
+        std::sort(reparseTimes.begin(), reparseTimes.end());
+        qDebug() << "reparsed" << instances << "instances between" << reparseTimes.first() << "and" << reparseTimes.last() << "ms, median"
+                 << reparseTimes.at(instances / 2) << "ms";
+        // The reparses are spread over the delay instead of happening at once
+        QVERIFY(reparseTimes.last() - reparseTimes.first() >= maxDelay / 2);
+        for (const auto &plugin : plugins) {
+            QVERIFY(!plugin->isConfigurationStale());
+        }
+    }
+};
+
+QTEST_MAIN(FrameworkIntegrationPlugin_UnitTest)
+
+#include "frameworkintegrationplugin_unittest.moc"
@@ -8,16 +8,33 @@
 #include "kdeplatformtheme_config.h"
 #include "kstyle.h"
 
+#include <KConfigGroup>
+#include <KSharedConfig>
+
 #include <QApplication>
+#include <QDialogButtonBox>
 #include <QDir>
 #include <QFile>
+#include <QHoverEvent>
+#include <QListView>
+#include <QPainter>
+#include <QPushButton>
+#include <QShortcut>
+#include <QSignalSpy>
 #include <QStandardPaths>
+#include <QStringListModel>
+#include <QStyleOption>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
 #include <QTest>
 #include <QToolBar>
 #include <QToolButton>
 
 #include <QDebug>
 
+#include <algorithm>
+#include <utility>
+
 static void prepareEnvironment()
 {
     QStandardPaths::setTestModeEnabled(true);
@@ -38,6 +55,72 @@ static void prepareEnvironment()
 
 Q_COREAPP_STARTUP_FUNCTION(prepareEnvironment)
 
+// Records the hover events which reach the view behind the style's event filters
+class HoverRecorder : public QObject
+{
+public:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        switch (event->type()) {
+        case QEvent::HoverEnter:
+        case QEvent::HoverMove:
+        case QEvent::HoverLeave:
+            events << qMakePair(event->type(), static_cast<QHoverEvent *>(event)->position());
+            break;
+        default:
+            break;
+        }
+        return QObject::eventFilter(watched, event);
+    }
+
+    QList<std::pair<QEvent::Type, QPointF>> events;
+};
+
+class TrimmableStyle : public KStyle
+{
+public:
+    TrimmableStyle()
+    {
+        addCacheTrimmer([this]() {
+            return std::exchange(cacheBytes, 0);
+        });
+        addMemoryUsageReporter([this]() {
+            return MemoryUsage{QStringLiteral("testCache"), cacheBytes ? 1 : 0, cacheBytes};
+        });
+        newStyleHint(QStringLiteral("SH_TestHint"));
+        newControlElement(QStringLiteral("CE_TestElement"));
+    }
+
+    using KStyle::cachedTile;
+
+    qint64 cacheBytes = 1000;
+};
+
+class CustomElementStyle : public KStyle
+{
+    Q_OBJECT
+    Q_CLASSINFO("X-KDE-CustomElements", "true")
+public:
+    using KStyle::newStyleHint;
+
+    explicit CustomElementStyle(bool reversed)
+    {
+        if (reversed) {
+            subElement = newSubElement(QStringLiteral("SE_TestSub"));
+            controlElement = newControlElement(QStringLiteral("CE_TestElement"));
+            hint = newStyleHint(QStringLiteral("SH_TestHint"));
+        } else {
+            hint = newStyleHint(QStringLiteral("SH_TestHint"));
+            controlElement = newControlElement(QStringLiteral("CE_TestElement"));
+            subElement = newSubElement(QStringLiteral("SE_TestSub"));
+        }
+    }
+
+    StyleHint hint;
+    ControlElement controlElement;
+    SubElement subElement;
+};
+
 class KStyle_UnitTest : public QObject
 {
     Q_OBJECT
@@ -63,6 +146,366 @@ private Q_SLOTS:
         toolbar->setProperty("otherToolbar", true);
         QCOMPARE(qApp->style()->styleHint(QStyle::SH_ToolButtonStyle, nullptr, btn), (int)Qt::ToolButtonTextUnderIcon);
     }
+
+    void testQueryStyle()
+    {
+        QToolBar toolbar;
+        QToolButton *btn = new QToolButton(&toolbar);
+        const QList<QStyle::StyleHint> hints = {QStyle::SH_DialogButtonBox_ButtonsHaveIcons,
+                                                QStyle::SH_ToolButtonStyle,
+                                                QStyle::SH_ScrollBar_LeftClickAbsolutePosition,
+                                                QStyle::SH_Widget_Animate,
+                                                QStyle::SH_ItemView_ArrowKeysNavigateIntoChildren,
+                                                QStyle::SH_Menu_SubMenuSloppyCloseTimeout};
+        const QList<QStyle::PixelMetric> metrics = {QStyle::PM_SmallIconSize, QStyle::PM_ToolBarIconSize, QStyle::PM_DefaultFrameWidth};
+
+        auto style = static_cast<KStyle *>(qApp->style());
+        const KStyle::StyleValues values = style->queryStyle(hints, metrics, nullptr, btn);
+        QCOMPARE(values.hints.size(), hints.size());
+        QCOMPARE(values.metrics.size(), metrics.size());
+        for (int i = 0; i < hints.size(); ++i) {
+            QCOMPARE(values.hints.at(i), style->styleHint(hints.at(i), nullptr, btn));
+        }
+        for (int i = 0; i < metrics.size(); ++i) {
+            QCOMPARE(values.metrics.at(i), style->pixelMetric(metrics.at(i), nullptr, btn));
+        }
+        QCOMPARE(values.hints.at(1), (int)Qt::ToolButtonTextOnly);
+    }
+
+    void testCustomElementIds()
+    {
+        CustomElementStyle firstStyle(false);
+        CustomElementStyle secondStyle(true);
+        CustomElementStyle *first = &firstStyle;
+        CustomElementStyle *second = &secondStyle;
+        QVERIFY(first->hint != 0);
+        QVERIFY(first->hint != first->controlElement);
+        // The ids don't depend on the instance or the order the elements were registered in
+        QCOMPARE(first->hint, second->hint);
+        QCOMPARE(first->controlElement, second->controlElement);
+        QCOMPARE(first->subElement, second->subElement);
+        // Registering an element again returns its id
+        QCOMPARE(first->newStyleHint(QStringLiteral("SH_TestHint")), first->hint);
+        QCOMPARE(first->newStyleHint(QStringLiteral("CE_Wrong")), QStyle::StyleHint(0));
+
+        QWidget widget;
+        widget.setStyle(first);
+        const QStyle::StyleHint cached = KStyle::customStyleHint(QStringLiteral("SH_TestHint"), &widget);
+        QCOMPARE(cached, first->hint);
+        QCOMPARE(KStyle::customStyleHint(QStringLiteral("SH_Unknown"), &widget), QStyle::StyleHint(0));
+
+        // After a style reload the cached id is still valid
+        widget.setStyle(second);
+        QCOMPARE(KStyle::customStyleHint(QStringLiteral("SH_TestHint"), &widget), cached);
+        QCOMPARE(KStyle::customControlElement(QStringLiteral("CE_TestElement"), &widget), first->controlElement);
+    }
+
+    void testDeferredPolish()
+    {
+        KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE-Global GUI Settings"));
+        g.writeEntry("DeferredPolish", true);
+        KStyle style;
+        g.deleteEntry("DeferredPolish");
+
+        QWidget window;
+        auto page = new QWidget(&window);
+        page->hide();
+        auto box = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, page);
+        window.show();
+
+        // A page hidden in a shown window is polished once it is shown first
+        QPushButton *okButton = box->button(QDialogButtonBox::Ok);
+        box->setStyle(&style);
+        QVERIFY(!okButton->findChild<QShortcut *>());
+
+        page->show();
+        QCOMPARE(okButton->findChildren<QShortcut *>().size(), 1);
+        page->hide();
+        page->show();
+        QCOMPARE(okButton->findChildren<QShortcut *>().size(), 1);
+    }
+
+    void testDeferredPolishVisibleWindow()
+    {
+        KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE-Global GUI Settings"));
+        g.writeEntry("DeferredPolish", true);
+        KStyle style;
+        g.deleteEntry("DeferredPolish");
+
+        // Widgets of a visible window, and of one not shown yet, are polished right away
+        QWidget window;
+        auto box = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &window);
+        window.show();
+        box->setStyle(&style);
+        QCOMPARE(box->button(QDialogButtonBox::Ok)->findChildren<QShortcut *>().size(), 1);
+
+        QDialogButtonBox hiddenBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+        hiddenBox.setStyle(&style);
+        QCOMPARE(hiddenBox.button(QDialogButtonBox::Ok)->findChildren<QShortcut *>().size(), 1);
+    }
+
+    void testCoalescedHover()
+    {
+        KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE-Global GUI Settings"));
+        g.writeEntry("CoalescedItemViewHover", true);
+        KStyle style;
+        g.revertToDefault("CoalescedItemViewHover");
+
+        QStringListModel model(QStringList{QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c")});
+        QListView view;
+        view.setModel(&model);
+        // Installed before the style's filter, so it only sees what the view gets
+        HoverRecorder recorder;
+        view.viewport()->installEventFilter(&recorder);
+        view.setStyle(&style);
+
+        QWidget *viewport = view.viewport();
+        const auto send = [viewport](QEvent::Type type, const QPointF &position, const QPointF &oldPosition) {
+            QHoverEvent event(type, position, viewport->mapToGlobal(position), oldPosition);
+            QCoreApplication::sendEvent(viewport, &event);
+        };
+
+        send(QEvent::HoverEnter, QPointF(1, 1), QPointF(-1, -1));
+        QCOMPARE(recorder.events.size(), 1);
+        QCOMPARE(recorder.events.last().first, QEvent::HoverEnter);
+
+        // The first move of a frame goes through, the others are coalesced into the latest one
+        for (int i = 2; i <= 10; ++i) {
+            send(QEvent::HoverMove, QPointF(i, i), QPointF(i - 1, i - 1));
+        }
+        QCOMPARE(recorder.events.size(), 2);
+        QCOMPARE(recorder.events.last(), qMakePair(QEvent::HoverMove, QPointF(2, 2)));
+        QTRY_COMPARE(recorder.events.size(), 3);
+        QCOMPARE(recorder.events.last(), qMakePair(QEvent::HoverMove, QPointF(10, 10)));
+
+        // Leaving drops a pending move and is delivered as is
+        send(QEvent::HoverMove, QPointF(11, 11), QPointF(10, 10));
+        send(QEvent::HoverMove, QPointF(12, 12), QPointF(11, 11));
+        send(QEvent::HoverLeave, QPointF(-1, -1), QPointF(12, 12));
+        QTest::qWait(50);
+        QCOMPARE(recorder.events.last().first, QEvent::HoverLeave);
+        QVERIFY(std::none_of(recorder.events.cbegin(), recorder.events.cend(), [](const std::pair<QEvent::Type, QPointF> &event) {
+            return event.second == QPointF(12, 12);
+        }));
+    }
+
+    void testAdaptiveAnimations()
+    {
+        KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE-Global GUI Settings"));
+        g.writeEntry("GraphicEffectsLevel", true);
+        g.writeEntry("AnimationFrameBudget", 10);
+        g.writeEntry("AnimationFrameWindow", 4);
+
+        // Off unless enabled
+        {
+            KStyle style;
+            for (int i = 0; i < 4; ++i) {
+                style.reportFrameTime(100000);
+            }
+            QCOMPARE(style.animationQuality(), KStyle::FullAnimations);
+        }
+
+        g.writeEntry("AdaptiveAnimations", true);
+        KStyle style;
+        QSignalSpy spy(&style, &KStyle::animationQualityChanged);
+        const auto reportFrames = [&style](int milliseconds) {
+            for (int i = 0; i < 4; ++i) {
+                style.reportFrameTime(milliseconds * 1000);
+            }
+        };
+
+        // Within budget
+        reportFrames(8);
+        QCOMPARE(style.animationQuality(), KStyle::FullAnimations);
+        QVERIFY(style.styleHint(QStyle::SH_Widget_Animate, nullptr, nullptr, nullptr));
+
+        reportFrames(15);
+        QCOMPARE(style.animationQuality(), KStyle::ReducedAnimations);
+        QVERIFY(style.styleHint(QStyle::SH_Widget_Animate, nullptr, nullptr, nullptr));
+
+        reportFrames(25);
+        QCOMPARE(style.animationQuality(), KStyle::NoAnimations);
+        QVERIFY(!style.styleHint(QStyle::SH_Widget_Animate, nullptr, nullptr, nullptr));
+        QCOMPARE(spy.count(), 2);
+        QCOMPARE(spy.last().at(0).value<KStyle::AnimationQuality>(), KStyle::NoAnimations);
+
+        // Between the recover and the reduce threshold nothing changes
+        reportFrames(8);
+        QCOMPARE(style.animationQuality(), KStyle::NoAnimations);
+
+        // Headroom brings the animations back one step at a time
+        reportFrames(3);
+        QCOMPARE(style.animationQuality(), KStyle::ReducedAnimations);
+        QVERIFY(style.styleHint(QStyle::SH_Widget_Animate, nullptr, nullptr, nullptr));
+        reportFrames(3);
+        QCOMPARE(style.animationQuality(), KStyle::FullAnimations);
+        QCOMPARE(spy.count(), 4);
+
+        g.revertToDefault("AdaptiveAnimations");
+        g.revertToDefault("AnimationFrameBudget");
+        g.revertToDefault("AnimationFrameWindow");
+        g.revertToDefault("GraphicEffectsLevel");
+    }
+
+    void testTrimCaches()
+    {
+        TrimmableStyle style;
+        QSignalSpy spy(&style, &KStyle::cachesTrimmed);
+        QCOMPARE(style.trimCaches(), 1000);
+        QCOMPARE(style.trimCaches(), 0);
+        QCOMPARE(spy.count(), 2);
+        QCOMPARE(spy.first().at(0).toLongLong(), 1000);
+    }
+
+    void testMemoryUsage()
+    {
+        TrimmableStyle style;
+        const auto usageOf = [&style](const QString &name) {
+            const QList<KStyle::MemoryUsage> usage = style.memoryUsage();
+            auto it = std::find_if(usage.cbegin(), usage.cend(), [&name](const KStyle::MemoryUsage &entry) {
+                return entry.name == name;
+            });
+            return it == usage.cend() ? KStyle::MemoryUsage{} : *it;
+        };
+
+        QCOMPARE(usageOf(QStringLiteral("customElements")).entries, 2);
+        QVERIFY(usageOf(QStringLiteral("customElements")).bytes > 0);
+        QCOMPARE(usageOf(QStringLiteral("testCache")).bytes, 1000);
+
+        style.trimCaches();
+        QCOMPARE(usageOf(QStringLiteral("testCache")).bytes, 0);
+        // Element ids have to stay stable, trimming keeps them
+        QCOMPARE(usageOf(QStringLiteral("customElements")).entries, 2);
+    }
+
+    void testTileCache()
+    {
+        TrimmableStyle style;
+        int renders = 0;
+        const auto render = [&renders](QPainter *painter) {
+            ++renders;
+            painter->fillRect(QRect(0, 0, 10, 10), Qt::red);
+        };
+
+        QStyleOption option;
+        option.state = QStyle::State_Enabled;
+        const QPixmap tile = style.cachedTile(QStringLiteral("frame"), &option, QSize(10, 10), 2.0, render);
+        QCOMPARE(tile.size(), QSize(20, 20));
+        QCOMPARE(tile.devicePixelRatio(), 2.0);
+        QCOMPARE(tile.toImage().pixelColor(19, 19), QColor(Qt::red));
+
+        // Another widget asking for the same tile gets the rendered one
+        style.cachedTile(QStringLiteral("frame"), &option, QSize(10, 10), 2.0, render);
+        QCOMPARE(renders, 1);
+
+        // Anything in the key being different renders again
+        style.cachedTile(QStringLiteral("frame"), &option, QSize(10, 10), 1.0, render);
+        option.state |= QStyle::State_MouseOver;
+        style.cachedTile(QStringLiteral("frame"), &option, QSize(10, 10), 1.0, render);
+        option.palette.setColor(QPalette::Window, Qt::blue);
+        style.cachedTile(QStringLiteral("frame"), &option, QSize(10, 10), 1.0, render);
+        QCOMPARE(renders, 4);
+
+        KStyle::TileCacheStatistics statistics = style.tileCacheStatistics();
+        QCOMPARE(statistics.hits, 1);
+        QCOMPARE(statistics.misses, 4);
+        QCOMPARE(statistics.entries, 4);
+        QCOMPARE(statistics.bytes, 20 * 20 * 4 + 3 * 10 * 10 * 4);
+
+        // The least recently used tiles go first
+        style.setTileCacheLimit(2 * 10 * 10 * 4);
+        statistics = style.tileCacheStatistics();
+        QCOMPARE(statistics.entries, 2);
+        style.cachedTile(QStringLiteral("frame"), &option, QSize(10, 10), 1.0, render);
+        QCOMPARE(renders, 4);
+
+        const qint64 tileBytes = style.tileCacheStatistics().bytes;
+        style.cacheBytes = 0;
+        QCOMPARE(style.trimCaches(), tileBytes);
+        QCOMPARE(style.tileCacheStatistics().entries, 0);
+    }
+
+    void testLinkIcons()
+    {
+        // A theme with just the icons the link icons are composed of
+        QTemporaryDir themes;
+        QVERIFY(QDir(themes.path()).mkpath(QStringLiteral("linktest/32x32")));
+        QFile index(themes.path() + QStringLiteral("/linktest/index.theme"));
+        QVERIFY(index.open(QIODevice::WriteOnly));
+        index.write("[Icon Theme]\nName=linktest\nDirectories=32x32\n\n[32x32]\nSize=32\nType=Fixed\n");
+        index.close();
+        const auto writeIcon = [&themes](const QString &name, const QColor &color) {
+            QImage image(32, 32, QImage::Format_ARGB32);
+            image.fill(color);
+            return image.save(themes.path() + QStringLiteral("/linktest/32x32/") + name + QStringLiteral(".png"));
+        };
+        QVERIFY(writeIcon(QStringLiteral("text-plain"), Qt::blue));
+        QVERIFY(writeIcon(QStringLiteral("emblem-symbolic-link"), Qt::red));
+        const QStringList searchPaths = QIcon::themeSearchPaths();
+        const QString themeName = QIcon::themeName();
+        QIcon::setThemeSearchPaths({themes.path()});
+        QIcon::setThemeName(QStringLiteral("linktest"));
+
+        TrimmableStyle style;
+        const auto iconCacheEntries = [&style]() {
+            const QList<KStyle::MemoryUsage> usage = style.memoryUsage();
+            auto it = std::find_if(usage.cbegin(), usage.cend(), [](const KStyle::MemoryUsage &entry) {
+                return entry.name == QLatin1String("iconCache");
+            });
+            return it == usage.cend() ? -1 : it->entries;
+        };
+
+        const QIcon icon = style.standardIcon(QStyle::SP_FileLinkIcon);
+        QCOMPARE(icon.cacheKey(), style.standardIcon(QStyle::SP_FileLinkIcon).cacheKey());
+        const QImage image = icon.pixmap(QSize(32, 32), 1.0).toImage();
+        QCOMPARE(image.pixelColor(0, 0), QColor(Qt::blue));
+        QCOMPARE(image.pixelColor(31, 31), QColor(Qt::red));
+        QCOMPARE(iconCacheEntries(), 1);
+
+        // Every further item showing a link reuses the composed pixmap
+        icon.pixmap(QSize(32, 32), 1.0);
+        style.standardIcon(QStyle::SP_FileLinkIcon).pixmap(QSize(32, 32), 1.0);
+        QCOMPARE(iconCacheEntries(), 1);
+        icon.pixmap(QSize(32, 32), 2.0);
+        QCOMPARE(iconCacheEntries(), 2);
+
+        style.cacheBytes = 0;
+        QVERIFY(style.trimCaches() > 0);
+        QCOMPARE(iconCacheEntries(), 0);
+
+        QIcon::setThemeName(themeName);
+        QIcon::setThemeSearchPaths(searchPaths);
+    }
+
+    void testMemoryPressure()
+    {
+        QTemporaryFile psiFile;
+        QVERIFY(psiFile.open());
+        const auto writePressure = [&psiFile](const QByteArray &avg10) {
+            psiFile.resize(0);
+            psiFile.write("some avg10=" + avg10 + " avg60=0.00 avg300=0.00 total=0\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+            psiFile.flush();
+        };
+        writePressure("0.50");
+        qputenv("KSTYLE_PSI_FILE", psiFile.fileName().toLocal8Bit());
+        KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE-Global GUI Settings"));
+        g.writeEntry("TrimCachesOnMemoryPressure", true);
+        g.writeEntry("MemoryPressurePollInterval", 20);
+
+        TrimmableStyle style;
+        QSignalSpy spy(&style, &KStyle::cachesTrimmed);
+        QTest::qWait(100);
+        QCOMPARE(spy.count(), 0);
+
+        writePressure("42.00");
+        QTRY_COMPARE(spy.count(), 1);
+        QCOMPARE(spy.first().at(0).toLongLong(), 1000);
+        QCOMPARE(style.cacheBytes, 0);
+
+        g.revertToDefault("TrimCachesOnMemoryPressure");
+        g.revertToDefault("MemoryPressurePollInterval");
+        qunsetenv("KSTYLE_PSI_FILE");
+    }
 };
 
 QTEST_MAIN(KStyle_UnitTest)
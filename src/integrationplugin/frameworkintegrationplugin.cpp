@@ -11,11 +11,21 @@
 #include <KSharedConfig>
 
 #include <QDebug>
+#include <QRandomGenerator>
 #include <qplugin.h>
 
+KConfig *KMessageBoxDontAskAgainConfigStorage::config() const
+{
+    if (KMessageBox_againConfig) {
+        return KMessageBox_againConfig;
+    }
+    m_plugin->reparseIfStale();
+    return KSharedConfig::openConfig().data();
+}
+
 bool KMessageBoxDontAskAgainConfigStorage::shouldBeShownTwoActions(const QString &dontShowAgainName, KMessageBox::ButtonCode &result)
 {
-    KConfigGroup cg(KMessageBox_againConfig ? KMessageBox_againConfig : KSharedConfig::openConfig().data(), QStringLiteral("Notification Messages"));
+    KConfigGroup cg(config(), QStringLiteral("Notification Messages"));
     const QString dontAsk = cg.readEntry(dontShowAgainName, QString()).toLower();
     if (dontAsk == QLatin1String("yes") || dontAsk == QLatin1String("true")) {
         result = KMessageBox::PrimaryAction;
@@ -30,7 +40,7 @@ bool KMessageBoxDontAskAgainConfigStorage::shouldBeShownTwoActions(const QString
 
 bool KMessageBoxDontAskAgainConfigStorage::shouldBeShownContinue(const QString &dontShowAgainName)
 {
-    KConfigGroup cg(KMessageBox_againConfig ? KMessageBox_againConfig : KSharedConfig::openConfig().data(), QStringLiteral("Notification Messages"));
+    KConfigGroup cg(config(), QStringLiteral("Notification Messages"));
     return cg.readEntry(dontShowAgainName, true);
 }
 
@@ -40,7 +50,7 @@ void KMessageBoxDontAskAgainConfigStorage::saveDontShowAgainTwoActions(const QSt
     if (dontShowAgainName[0] == QLatin1Char(':')) {
         flags |= KConfigGroup::Global;
     }
-    KConfigGroup cg(KMessageBox_againConfig ? KMessageBox_againConfig : KSharedConfig::openConfig().data(), QStringLiteral("Notification Messages"));
+    KConfigGroup cg(config(), QStringLiteral("Notification Messages"));
     cg.writeEntry(dontShowAgainName, result == KMessageBox::PrimaryAction, flags);
     cg.sync();
 }
@@ -51,14 +61,14 @@ void KMessageBoxDontAskAgainConfigStorage::saveDontShowAgainContinue(const QStri
     if (dontShowAgainName[0] == QLatin1Char(':')) {
         flags |= KConfigGroup::Global;
     }
-    KConfigGroup cg(KMessageBox_againConfig ? KMessageBox_againConfig : KSharedConfig::openConfig().data(), QStringLiteral("Notification Messages"));
+    KConfigGroup cg(config(), QStringLiteral("Notification Messages"));
     cg.writeEntry(dontShowAgainName, false, flags);
     cg.sync();
 }
 
 void KMessageBoxDontAskAgainConfigStorage::enableAllMessages()
 {
-    KConfig *config = KMessageBox_againConfig ? KMessageBox_againConfig : KSharedConfig::openConfig().data();
+    KConfig *config = this->config();
     if (!config->hasGroup(QStringLiteral("Notification Messages"))) {
         return;
     }
@@ -77,7 +87,7 @@ void KMessageBoxDontAskAgainConfigStorage::enableAllMessages()
 
 void KMessageBoxDontAskAgainConfigStorage::enableMessage(const QString &dontShowAgainName)
 {
-    KConfig *config = KMessageBox_againConfig ? KMessageBox_againConfig : KSharedConfig::openConfig().data();
+    KConfig *config = this->config();
     if (!config->hasGroup(QStringLiteral("Notification Messages"))) {
         return;
     }
@@ -111,14 +121,75 @@ void KMessageBoxNotify::sendNotification(QMessageBox::Icon notificationType, con
 
 KFrameworkIntegrationPlugin::KFrameworkIntegrationPlugin()
     : QObject()
+    , m_dontAskAgainConfigStorage(this)
 {
     setProperty(KMESSAGEBOXDONTASKAGAIN_PROPERTY, QVariant::fromValue<KMessageBoxDontAskAgainInterface *>(&m_dontAskAgainConfigStorage));
     setProperty(KMESSAGEBOXNOTIFY_PROPERTY, QVariant::fromValue<KMessageBoxNotifyInterface *>(&m_notify));
+
+    // LazyConfigReparse delays the settings change for every reader of the application's
+    // config by up to ConfigReparseMaxDelay msecs, only the plugin's own reads reparse first
+    KConfigGroup cg(KSharedConfig::openConfig(), QStringLiteral("KDE-Global GUI Settings"));
+    m_lazyReparse = cg.readEntry("LazyConfigReparse", false);
+    m_maxReparseDelay = qMax(0, cg.readEntry("ConfigReparseMaxDelay", 2000));
+
+    m_reparseTimer.setSingleShot(true);
+    connect(&m_reparseTimer, &QTimer::timeout, this, &KFrameworkIntegrationPlugin::reparseIfStale);
+}
+
+void KFrameworkIntegrationPlugin::setLazyReparse(bool lazy)
+{
+    m_lazyReparse = lazy;
+    if (!lazy) {
+        reparseIfStale();
+    }
+}
+
+bool KFrameworkIntegrationPlugin::lazyReparse() const
+{
+    return m_lazyReparse;
+}
+
+void KFrameworkIntegrationPlugin::setMaxReparseDelay(int msecs)
+{
+    m_maxReparseDelay = qMax(0, msecs);
+}
+
+int KFrameworkIntegrationPlugin::maxReparseDelay() const
+{
+    return m_maxReparseDelay;
+}
+
+bool KFrameworkIntegrationPlugin::isConfigurationStale() const
+{
+    return m_stale;
+}
+
+void KFrameworkIntegrationPlugin::reparseIfStale()
+{
+    if (m_stale) {
+        doReparse();
+    }
 }
 
 void KFrameworkIntegrationPlugin::reparseConfiguration()
 {
+    if (!m_lazyReparse) {
+        doReparse();
+        return;
+    }
+    // Several notifications within the delay result in a single reparse
+    if (!m_stale) {
+        m_stale = true;
+        m_reparseTimer.start(QRandomGenerator::global()->bounded(m_maxReparseDelay + 1));
+    }
+}
+
+void KFrameworkIntegrationPlugin::doReparse()
+{
+    m_stale = false;
+    m_reparseTimer.stop();
     KSharedConfig::openConfig()->reparseConfiguration();
+    Q_EMIT configurationReparsed();
 }
 
 #include "moc_frameworkintegrationplugin.cpp"
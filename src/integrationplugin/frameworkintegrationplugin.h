@@ -11,14 +11,17 @@
 #include <KMessageBoxDontAskAgainInterface>
 #include <KMessageBoxNotifyInterface>
 #include <QObject>
+#include <QTimer>
 
 class KConfig;
+class KFrameworkIntegrationPlugin;
 
 class KMessageBoxDontAskAgainConfigStorage : public KMessageBoxDontAskAgainInterface
 {
 public:
-    KMessageBoxDontAskAgainConfigStorage()
+    explicit KMessageBoxDontAskAgainConfigStorage(KFrameworkIntegrationPlugin *plugin)
         : KMessageBox_againConfig(nullptr)
+        , m_plugin(plugin)
     {
     }
     ~KMessageBoxDontAskAgainConfigStorage() override
@@ -37,7 +40,11 @@ public:
     }
 
 private:
+    // The custom config or the application's, which is reparsed first if it is stale
+    KConfig *config() const;
+
     KConfig *KMessageBox_againConfig;
+    KFrameworkIntegrationPlugin *const m_plugin;
 };
 
 class KMessageBoxNotify : public KMessageBoxNotifyInterface
@@ -53,12 +60,44 @@ class KFrameworkIntegrationPlugin : public QObject
 public:
     KFrameworkIntegrationPlugin();
 
+    /**
+     * In lazy mode reparseConfiguration() only marks the configuration as stale. It is
+     * reparsed when the plugin reads it next or after a random delay of at most
+     * maxReparseDelay() msecs, whichever comes first. This spreads the reparsing of all
+     * running applications after a settings change instead of doing it all at once.
+     *
+     * This delays the settings change itself: everything else reading the application's
+     * configuration, e.g. KStyle or the platform theme, sees the old values until the
+     * reparse, i.e. for up to maxReparseDelay() msecs.
+     *
+     * Defaults to the LazyConfigReparse and ConfigReparseMaxDelay (2000) entries of the
+     * "KDE-Global GUI Settings" group.
+     */
+    void setLazyReparse(bool lazy);
+    bool lazyReparse() const;
+
+    void setMaxReparseDelay(int msecs);
+    int maxReparseDelay() const;
+
+    bool isConfigurationStale() const;
+    /// Reparses the configuration now if reparseConfiguration() was deferred
+    void reparseIfStale();
+
 public Q_SLOTS:
     void reparseConfiguration();
 
+Q_SIGNALS:
+    void configurationReparsed();
+
 private:
+    void doReparse();
+
     KMessageBoxDontAskAgainConfigStorage m_dontAskAgainConfigStorage;
     KMessageBoxNotify m_notify;
+    QTimer m_reparseTimer;
+    bool m_lazyReparse = false;
+    int m_maxReparseDelay = 2000;
+    bool m_stale = false;
 };
 
 #endif // FRAMEWORKINTEGRATIONPLUGIN_H
@@ -0,0 +1,93 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "appstreamjobs.h"
+#include "handlerutils.h"
+
+#include <AppStreamQt/pool.h>
+#include <PackageKit/Transaction>
+#include <QDebug>
+
+CatalogLoadJob::CatalogLoadJob(AppStream::Pool *pool, QObject *parent)
+    : HandlerJob(QStringLiteral("pool-load"), parent)
+    , m_pool(pool)
+{
+    m_progressTimer.setInterval(5000);
+    connect(&m_progressTimer, &QTimer::timeout, this, [this]() {
+        qInfo() << "still loading the AppStream catalog," << m_loadTimer.elapsed() / 1000 << "s elapsed";
+    });
+}
+
+void CatalogLoadJob::start()
+{
+    connect(m_pool, &AppStream::Pool::loadFinished, this, [this](bool success) {
+        m_progressTimer.stop();
+        if (!success) {
+            qWarning() << "couldn't load the AppStream catalog" << m_pool->lastError();
+        }
+        emitResult(success ? KPackageHandler::ExitSuccess : KPackageHandler::ExitFailure);
+    });
+    m_loadTimer.start();
+    m_progressTimer.start();
+    m_pool->loadAsync();
+}
+
+void CatalogLoadJob::doCancel()
+{
+    // The pool has no way to abort a load, its result is just not waited for anymore.
+    // Whoever owns the pool must not destroy it before the load finished.
+    m_progressTimer.stop();
+    disconnect(m_pool, nullptr, this, nullptr);
+}
+
+TransactionJob::TransactionJob(const QString &name, const TransactionFactory &factory, QObject *parent)
+    : HandlerJob(name, parent)
+    , m_factory(factory)
+{
+}
+
+QString TransactionJob::errorText() const
+{
+    return m_errorText;
+}
+
+void TransactionJob::start()
+{
+    m_transaction = m_factory();
+    if (!m_transaction) {
+        emitResult(KPackageHandler::ExitFailure);
+        return;
+    }
+    connect(m_transaction, &PackageKit::Transaction::errorCode, this, [this](PackageKit::Transaction::Error error, const QString &details) {
+        qWarning() << name() << "error" << error << details;
+        m_errorText = details;
+    });
+    connect(m_transaction, &PackageKit::Transaction::finished, this, [this](PackageKit::Transaction::Exit status) {
+        qDebug() << name() << "finished" << status;
+        switch (status) {
+        case PackageKit::Transaction::ExitSuccess:
+            emitResult(KPackageHandler::ExitSuccess);
+            break;
+        case PackageKit::Transaction::ExitCancelled:
+        case PackageKit::Transaction::ExitCancelledPriority:
+            emitResult(KPackageHandler::ExitCancelled);
+            break;
+        default:
+            emitResult(KPackageHandler::ExitFailure);
+            break;
+        }
+    });
+}
+
+void TransactionJob::doCancel()
+{
+    if (m_transaction) {
+        m_transaction->cancel();
+    }
+}
+
+#include "moc_appstreamjobs.cpp"
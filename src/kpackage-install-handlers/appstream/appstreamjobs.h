@@ -0,0 +1,76 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef APPSTREAMJOBS_H
+#define APPSTREAMJOBS_H
+
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+
+#include <functional>
+
+#include "handlerjob.h"
+
+namespace AppStream
+{
+class Pool;
+}
+
+namespace PackageKit
+{
+class Transaction;
+}
+
+/**
+ * Loads the AppStream catalog in the background and logs its progress every few seconds,
+ * so that a slow load is visible and can be given up on through the job's deadline.
+ */
+class CatalogLoadJob : public HandlerJob
+{
+    Q_OBJECT
+public:
+    explicit CatalogLoadJob(AppStream::Pool *pool, QObject *parent = nullptr);
+
+protected:
+    void start() override;
+    void doCancel() override;
+
+private:
+    AppStream::Pool *const m_pool;
+    QElapsedTimer m_loadTimer;
+    QTimer m_progressTimer;
+};
+
+/**
+ * Runs a single PackageKit transaction, which is cancelled together with the job.
+ *
+ * The transaction is only created once the job starts, so that the factory can
+ * use the results of the jobs that ran before.
+ */
+class TransactionJob : public HandlerJob
+{
+    Q_OBJECT
+public:
+    using TransactionFactory = std::function<PackageKit::Transaction *()>;
+
+    TransactionJob(const QString &name, const TransactionFactory &factory, QObject *parent = nullptr);
+
+    /// The details PackageKit gave for the error the transaction failed with, if any
+    QString errorText() const;
+
+protected:
+    void start() override;
+    void doCancel() override;
+
+private:
+    const TransactionFactory m_factory;
+    QPointer<PackageKit::Transaction> m_transaction;
+    QString m_errorText;
+};
+
+#endif // APPSTREAMJOBS_H
@@ -0,0 +1,160 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "componentindex.h"
+
+#include <AppStreamQt/metadata.h>
+#include <AppStreamQt/pool.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// Bump when the layout of the index file changes
+static const quint32 s_indexVersion = 1;
+
+static QStringList catalogOverrideDirs()
+{
+    return qEnvironmentVariable("APPSTREAMHANDLER_CATALOG_DIRS").split(QLatin1Char(':'), Qt::SkipEmptyParts);
+}
+
+static QStringList catalogDirs()
+{
+    const QStringList overrideDirs = catalogOverrideDirs();
+    if (!overrideDirs.isEmpty()) {
+        return overrideDirs;
+    }
+    return {
+        QStringLiteral("/usr/share/swcatalog"),
+        QStringLiteral("/var/lib/swcatalog"),
+        QStringLiteral("/var/cache/swcatalog"),
+        QStringLiteral("/usr/share/app-info"),
+        QStringLiteral("/var/lib/app-info"),
+        QStringLiteral("/var/cache/app-info"),
+    };
+}
+
+ComponentIndex::ComponentIndex()
+    : ComponentIndex(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/appstreamhandler/components.index"))
+{
+}
+
+ComponentIndex::ComponentIndex(const QString &fileName)
+    : m_fileName(fileName)
+{
+}
+
+QByteArray ComponentIndex::catalogFingerprint()
+{
+    // Metadata is added, updated and removed file by file in these subdirectories, which bumps their mtime.
+    // The icons directories are skipped, they are large and don't affect the package names.
+    static const QStringList metadataSubdirs = {QStringLiteral("."), QStringLiteral("xml"), QStringLiteral("yaml"), QStringLiteral("cache")};
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const QString &dir : catalogDirs()) {
+        for (const QString &subdir : metadataSubdirs) {
+            const QFileInfo info(dir + QLatin1Char('/') + subdir);
+            if (!info.isDir()) {
+                continue;
+            }
+            hash.addData(info.absoluteFilePath().toUtf8());
+            hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+            // Files might be replaced in place by package managers
+            const QFileInfoList files = QDir(info.absoluteFilePath()).entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
+            for (const QFileInfo &file : files) {
+                hash.addData(file.fileName().toUtf8());
+                hash.addData(QByteArray::number(file.lastModified().toMSecsSinceEpoch()));
+                hash.addData(QByteArray::number(file.size()));
+            }
+        }
+    }
+    return hash.result().toHex();
+}
+
+void ComponentIndex::applyCatalogOverride(AppStream::Pool &pool)
+{
+    const QStringList overrideDirs = catalogOverrideDirs();
+    if (overrideDirs.isEmpty()) {
+        return;
+    }
+    pool.setLoadStdDataLocations(false);
+    for (const QString &dir : overrideDirs) {
+        pool.addExtraDataLocation(dir, AppStream::Metadata::FormatStyleCatalog);
+    }
+}
+
+bool ComponentIndex::load(const QByteArray &fingerprint)
+{
+    m_valid = false;
+    m_packages.clear();
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 version;
+    stream >> version;
+    if (version != s_indexVersion) {
+        return false;
+    }
+    stream >> m_fingerprint;
+    if (m_fingerprint != fingerprint) {
+        qDebug() << "component index is outdated";
+        return false;
+    }
+    stream >> m_packages;
+    m_valid = stream.status() == QDataStream::Ok;
+    return m_valid;
+}
+
+bool ComponentIndex::isValid() const
+{
+    return m_valid;
+}
+
+QStringList ComponentIndex::packageNames(const QString &componentId) const
+{
+    return m_packages.value(componentId);
+}
+
+bool ComponentIndex::rebuild(AppStream::Pool &pool, const QByteArray &fingerprint)
+{
+    m_packages.clear();
+    const auto components = pool.components().toList();
+    for (const auto &component : components) {
+        const QStringList packageNames = component.packageNames();
+        if (packageNames.isEmpty()) {
+            continue;
+        }
+        QStringList &indexed = m_packages[component.id()];
+        indexed += packageNames;
+        indexed.removeDuplicates();
+    }
+    m_fingerprint = fingerprint;
+    m_valid = true;
+    return save();
+}
+
+bool ComponentIndex::save() const
+{
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "couldn't write the component index" << m_fileName << file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream << s_indexVersion << m_fingerprint << m_packages;
+    return file.commit();
+}
@@ -0,0 +1,64 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef COMPONENTINDEX_H
+#define COMPONENTINDEX_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+namespace AppStream
+{
+class Pool;
+}
+
+/**
+ * Persisted map of AppStream component ids to the names of the packages providing them.
+ *
+ * Loading the whole AppStream pool is by far the most expensive part of the handler,
+ * while it only needs the package names of a single component. The index is stamped
+ * with a fingerprint of the catalog directories' modification times and is only
+ * considered valid as long as the catalog didn't change.
+ */
+class ComponentIndex
+{
+public:
+    /// Uses the default location in the user's cache directory
+    ComponentIndex();
+    explicit ComponentIndex(const QString &fileName);
+
+    /**
+     * Computes the fingerprint of the metadata the AppStream pool is loaded from.
+     * The directories can be overridden with the colon separated APPSTREAMHANDLER_CATALOG_DIRS.
+     */
+    static QByteArray catalogFingerprint();
+
+    /// Makes @p pool load nothing but the APPSTREAMHANDLER_CATALOG_DIRS, if they are set
+    static void applyCatalogOverride(AppStream::Pool &pool);
+
+    /// Loads the index, returns false if it doesn't exist or was built for another catalog
+    bool load(const QByteArray &fingerprint);
+    bool isValid() const;
+
+    /// Returns the package names of @p componentId, empty if the component isn't indexed
+    QStringList packageNames(const QString &componentId) const;
+
+    /// Rebuilds the index from a loaded @p pool and saves it
+    bool rebuild(AppStream::Pool &pool, const QByteArray &fingerprint);
+
+private:
+    bool save() const;
+
+    const QString m_fileName;
+    QByteArray m_fingerprint;
+    QHash<QString, QStringList> m_packages;
+    bool m_valid = false;
+};
+
+#endif // COMPONENTINDEX_H
@@ -0,0 +1,161 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "fakepackagekit.h"
+
+#include <PackageKit/Transaction>
+#include <QDBusConnection>
+#include <QDebug>
+#include <QFile>
+
+static const QString s_serviceName = QStringLiteral("org.freedesktop.PackageKit");
+
+// PackageKit package ids are "name;version;arch;data"
+static QString packageId(const QString &name)
+{
+    return name + QLatin1String(";1.0;noarch;fixture");
+}
+
+FakePackageKit::FakePackageKit(const FakePackageKitConfig &config, QObject *parent)
+    : QObject(parent)
+    , m_config(config)
+{
+}
+
+bool FakePackageKit::registerService()
+{
+    // The handler finds us on its system bus, which the runner points at this bus
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.registerObject(QStringLiteral("/org/freedesktop/PackageKit"), this, QDBusConnection::ExportAllContents)) {
+        qWarning() << "couldn't register the PackageKit object" << bus.lastError().message();
+        return false;
+    }
+    if (!bus.registerService(s_serviceName)) {
+        qWarning() << "couldn't register" << s_serviceName << bus.lastError().message();
+        return false;
+    }
+    return true;
+}
+
+qulonglong FakePackageKit::roles() const
+{
+    return (1ULL << PackageKit::Transaction::RoleResolve) | (1ULL << PackageKit::Transaction::RoleInstallPackages);
+}
+
+int FakePackageKit::transactionCount() const
+{
+    return m_transactionCount;
+}
+
+void FakePackageKit::resetTransactionCount()
+{
+    m_transactionCount = 0;
+}
+
+QDBusObjectPath FakePackageKit::CreateTransaction()
+{
+    const QString path = QStringLiteral("/%1_fixture").arg(++m_transactionSerial);
+    auto transaction = new FakeTransaction(m_config, path, this);
+    if (!QDBusConnection::sessionBus().registerObject(path, transaction, QDBusConnection::ExportAllContents)) {
+        qWarning() << "couldn't register transaction" << path;
+        delete transaction;
+        return {};
+    }
+    ++m_transactionCount;
+    return QDBusObjectPath(path);
+}
+
+FakeTransaction::FakeTransaction(const FakePackageKitConfig &config, const QString &path, QObject *parent)
+    : QObject(parent)
+    , m_config(config)
+    , m_path(path)
+{
+    m_delayTimer.setSingleShot(true);
+}
+
+void FakeTransaction::SetHints(const QStringList &hints)
+{
+    Q_UNUSED(hints)
+}
+
+void FakeTransaction::Resolve(qulonglong filter, const QStringList &packages)
+{
+    Q_UNUSED(filter)
+    qDebug() << "fake PackageKit: resolve" << packages;
+    connect(&m_delayTimer, &QTimer::timeout, this, [this, packages]() {
+        if (m_config.failResolve) {
+            Q_EMIT ErrorCode(PackageKit::Transaction::ErrorRepoNotAvailable, QStringLiteral("fixture repository not available"));
+            finish(PackageKit::Transaction::ExitFailed);
+            return;
+        }
+        const QStringList installed = installedPackages();
+        for (const QString &package : packages) {
+            if (m_config.missingPackages.contains(package)) {
+                continue;
+            }
+            const auto info = installed.contains(package) ? PackageKit::Transaction::InfoInstalled : PackageKit::Transaction::InfoAvailable;
+            Q_EMIT Package(info, packageId(package), QStringLiteral("Fixture package"));
+        }
+        finish(PackageKit::Transaction::ExitSuccess);
+    });
+    m_delayTimer.start(m_config.resolveDelay);
+}
+
+void FakeTransaction::InstallPackages(qulonglong transactionFlags, const QStringList &packageIds)
+{
+    Q_UNUSED(transactionFlags)
+    qDebug() << "fake PackageKit: install" << packageIds;
+    connect(&m_delayTimer, &QTimer::timeout, this, [this, packageIds]() {
+        QStringList names;
+        for (const QString &id : packageIds) {
+            const QString name = id.section(QLatin1Char(';'), 0, 0);
+            if (m_config.failingPackages.contains(name)) {
+                Q_EMIT ErrorCode(PackageKit::Transaction::ErrorInternalError, QStringLiteral("%1 failed to install").arg(name));
+                finish(PackageKit::Transaction::ExitFailed);
+                return;
+            }
+            names << name;
+        }
+        if (!m_config.packageDatabase.isEmpty()) {
+            QFile database(m_config.packageDatabase);
+            if (database.open(QIODevice::Append | QIODevice::Text)) {
+                database.write(names.join(QLatin1Char('\n')).toUtf8() + '\n');
+            }
+        }
+        finish(PackageKit::Transaction::ExitSuccess);
+    });
+    m_delayTimer.start(m_config.installDelay);
+}
+
+void FakeTransaction::Cancel()
+{
+    if (!m_delayTimer.isActive()) {
+        return;
+    }
+    m_delayTimer.stop();
+    Q_EMIT ErrorCode(PackageKit::Transaction::ErrorTransactionCancelled, QStringLiteral("cancelled"));
+    finish(PackageKit::Transaction::ExitCancelled);
+}
+
+QStringList FakeTransaction::installedPackages() const
+{
+    QFile database(m_config.packageDatabase);
+    if (m_config.packageDatabase.isEmpty() || !database.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return {};
+    }
+    return QString::fromUtf8(database.readAll()).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+}
+
+void FakeTransaction::finish(uint exit)
+{
+    Q_EMIT Finished(exit, 0);
+    Q_EMIT Destroy();
+    QDBusConnection::sessionBus().unregisterObject(m_path);
+    deleteLater();
+}
+
+#include "moc_fakepackagekit.cpp"
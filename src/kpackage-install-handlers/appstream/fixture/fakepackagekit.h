@@ -0,0 +1,119 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef FAKEPACKAGEKIT_H
+#define FAKEPACKAGEKIT_H
+
+#include <QDBusObjectPath>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+/**
+ * The behavior of the fake daemon, shared by all of its transactions.
+ */
+struct FakePackageKitConfig {
+    /// Milliseconds a transaction takes before it reports its result
+    int resolveDelay = 0;
+    int installDelay = 0;
+    /// Packages resolve doesn't know about
+    QSet<QString> missingPackages;
+    /// Packages whose install fails
+    QSet<QString> failingPackages;
+    /// Whether resolve transactions fail as a whole
+    bool failResolve = false;
+    /// Names of the installed packages, one per line, installs append to it
+    QString packageDatabase;
+};
+
+/**
+ * Just enough of org.freedesktop.PackageKit for PackageKit-Qt to run resolve and install transactions.
+ */
+class FakePackageKit : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.PackageKit")
+    Q_PROPERTY(uint VersionMajor READ versionMajor)
+    Q_PROPERTY(uint VersionMinor READ versionMinor)
+    Q_PROPERTY(uint VersionMicro READ versionMicro)
+    Q_PROPERTY(QString BackendName READ backendName)
+    Q_PROPERTY(QString DistroId READ backendName)
+    Q_PROPERTY(qulonglong Roles READ roles)
+    Q_PROPERTY(bool Locked READ locked)
+public:
+    explicit FakePackageKit(const FakePackageKitConfig &config, QObject *parent = nullptr);
+
+    bool registerService();
+
+    uint versionMajor() const
+    {
+        return 1;
+    }
+    uint versionMinor() const
+    {
+        return 2;
+    }
+    uint versionMicro() const
+    {
+        return 0;
+    }
+    QString backendName() const
+    {
+        return QStringLiteral("appstreamhandler-fixture");
+    }
+    qulonglong roles() const;
+    bool locked() const
+    {
+        return false;
+    }
+
+    /// Number of transactions created since the last reset
+    int transactionCount() const;
+    void resetTransactionCount();
+
+public Q_SLOTS:
+    QDBusObjectPath CreateTransaction();
+
+private:
+    const FakePackageKitConfig m_config;
+    int m_transactionSerial = 0;
+    int m_transactionCount = 0;
+};
+
+/**
+ * A single transaction, it reports its result after the configured delay and then goes away.
+ */
+class FakeTransaction : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.PackageKit.Transaction")
+public:
+    FakeTransaction(const FakePackageKitConfig &config, const QString &path, QObject *parent = nullptr);
+
+public Q_SLOTS:
+    void SetHints(const QStringList &hints);
+    void Resolve(qulonglong filter, const QStringList &packages);
+    void InstallPackages(qulonglong transactionFlags, const QStringList &packageIds);
+    void Cancel();
+
+Q_SIGNALS:
+    void Package(uint info, const QString &packageId, const QString &summary);
+    void ErrorCode(uint code, const QString &details);
+    void Finished(uint exit, uint runtime);
+    void Destroy();
+
+private:
+    QStringList installedPackages() const;
+    void finish(uint exit);
+
+    const FakePackageKitConfig &m_config;
+    const QString m_path;
+    QTimer m_delayTimer;
+};
+
+#endif // FAKEPACKAGEKIT_H
@@ -0,0 +1,150 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+
+#include <algorithm>
+
+#include "fakepackagekit.h"
+
+/**
+ * Runs the appstreamhandler command against a fake PackageKit daemon.
+ *
+ * Has to be started on a private session bus, e.g. through dbus-run-session. The fake daemon
+ * claims org.freedesktop.PackageKit on that bus and the handler is pointed at it as its system bus.
+ * Exits with 0 if the handler exited with the expected exit code every time.
+ */
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption resolveDelayOption(QStringLiteral("resolve-delay"), QStringLiteral("Milliseconds a resolve takes"), QStringLiteral("ms"), QStringLiteral("0"));
+    parser.addOption(resolveDelayOption);
+    QCommandLineOption installDelayOption(QStringLiteral("install-delay"), QStringLiteral("Milliseconds an install takes"), QStringLiteral("ms"), QStringLiteral("0"));
+    parser.addOption(installDelayOption);
+    QCommandLineOption missingOption(QStringLiteral("missing"), QStringLiteral("Package unknown to resolve, can be repeated"), QStringLiteral("package"));
+    parser.addOption(missingOption);
+    QCommandLineOption failOption(QStringLiteral("fail"), QStringLiteral("Package whose install fails, can be repeated"), QStringLiteral("package"));
+    parser.addOption(failOption);
+    QCommandLineOption failResolveOption(QStringLiteral("fail-resolve"), QStringLiteral("Fail every resolve transaction"));
+    parser.addOption(failResolveOption);
+    QCommandLineOption packageDatabaseOption(QStringLiteral("package-db"), QStringLiteral("File listing the installed packages"), QStringLiteral("file"));
+    parser.addOption(packageDatabaseOption);
+    QCommandLineOption expectExitOption(QStringLiteral("expect-exit"), QStringLiteral("Exit code the handler has to exit with"), QStringLiteral("code"), QStringLiteral("0"));
+    parser.addOption(expectExitOption);
+    QCommandLineOption expectTransactionsOption(QStringLiteral("expect-transactions"),
+                                                QStringLiteral("Number of PackageKit transactions a run has to create"),
+                                                QStringLiteral("count"));
+    parser.addOption(expectTransactionsOption);
+    QCommandLineOption repeatOption(QStringLiteral("repeat"),
+                                    QStringLiteral("Runs the handler this many times, starting each run with an empty package database, and prints the latencies"),
+                                    QStringLiteral("count"),
+                                    QStringLiteral("1"));
+    parser.addOption(repeatOption);
+    parser.addPositionalArgument(QStringLiteral("command"), QStringLiteral("The handler and its arguments"), QStringLiteral("-- command..."));
+    parser.process(app);
+
+    QStringList command = parser.positionalArguments();
+    if (command.isEmpty()) {
+        parser.showHelp(1);
+    }
+    const QString program = command.takeFirst();
+
+    const QString busAddress = qEnvironmentVariable("DBUS_SESSION_BUS_ADDRESS");
+    if (busAddress.isEmpty()) {
+        qWarning() << "no session bus, run through dbus-run-session";
+        return 1;
+    }
+
+    FakePackageKitConfig config;
+    config.resolveDelay = parser.value(resolveDelayOption).toInt();
+    config.installDelay = parser.value(installDelayOption).toInt();
+    const QStringList missingPackages = parser.values(missingOption);
+    config.missingPackages = QSet<QString>(missingPackages.begin(), missingPackages.end());
+    const QStringList failingPackages = parser.values(failOption);
+    config.failingPackages = QSet<QString>(failingPackages.begin(), failingPackages.end());
+    config.failResolve = parser.isSet(failResolveOption);
+    config.packageDatabase = parser.value(packageDatabaseOption);
+
+    FakePackageKit packageKit(config);
+    if (!packageKit.registerService()) {
+        return 1;
+    }
+
+    const int expectedExitCode = parser.value(expectExitOption).toInt();
+    const int expectedTransactions = parser.isSet(expectTransactionsOption) ? parser.value(expectTransactionsOption).toInt() : -1;
+    const int repeat = std::max(1, parser.value(repeatOption).toInt());
+    QList<qint64> latencies;
+    bool allPassed = true;
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(QStringLiteral("DBUS_SYSTEM_BUS_ADDRESS"), busAddress);
+    QProcess handler;
+    handler.setProcessEnvironment(environment);
+    handler.setProcessChannelMode(QProcess::ForwardedChannels);
+    handler.setProgram(program);
+    handler.setArguments(command);
+
+    QElapsedTimer timer;
+    const auto startRun = [&]() {
+        if (repeat > 1 && !config.packageDatabase.isEmpty()) {
+            QFile::resize(config.packageDatabase, 0);
+        }
+        packageKit.resetTransactionCount();
+        timer.start();
+        handler.start();
+    };
+
+    // The handler has to be waited for asynchronously, the fake daemon answers it from this event loop
+    QObject::connect(&handler, &QProcess::finished, &app, [&](int exitCode, QProcess::ExitStatus exitStatus) {
+        latencies << timer.elapsed();
+        if (exitStatus != QProcess::NormalExit || exitCode != expectedExitCode) {
+            qWarning() << program << "exited with" << exitCode << exitStatus << "expected" << expectedExitCode;
+            allPassed = false;
+        }
+        if (expectedTransactions >= 0 && packageKit.transactionCount() != expectedTransactions) {
+            qWarning() << program << "created" << packageKit.transactionCount() << "PackageKit transactions, expected" << expectedTransactions;
+            allPassed = false;
+        }
+        if (latencies.size() < repeat) {
+            startRun();
+            return;
+        }
+        QCoreApplication::exit(allPassed ? 0 : 1);
+    });
+    QObject::connect(&handler, &QProcess::errorOccurred, &app, [&](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            qWarning() << "couldn't start" << program << handler.errorString();
+            QCoreApplication::exit(1);
+        }
+    });
+
+    startRun();
+    const int result = app.exec();
+
+    if (repeat > 1 && latencies.size() == repeat) {
+        // The first run loads the catalog and builds the component index, the others use the index
+        const qint64 first = latencies.takeFirst();
+        std::sort(latencies.begin(), latencies.end());
+        qInfo().noquote() << QStringLiteral("appstreamhandler benchmark: %1 runs, first %2 ms, min %3 ms, median %4 ms, max %5 ms (resolve delay %6 ms, install delay %7 ms)")
+                                 .arg(repeat)
+                                 .arg(first)
+                                 .arg(latencies.constFirst())
+                                 .arg(latencies.at(latencies.size() / 2))
+                                 .arg(latencies.constLast())
+                                 .arg(config.resolveDelay)
+                                 .arg(config.installDelay);
+    }
+    return result;
+}
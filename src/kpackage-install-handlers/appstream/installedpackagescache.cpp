@@ -0,0 +1,140 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "installedpackagescache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// Bump when the layout of the snapshot file changes
+static const quint32 s_snapshotVersion = 1;
+
+static QStringList packageDatabaseFiles()
+{
+    const QString files = qEnvironmentVariable("APPSTREAMHANDLER_PACKAGE_DB");
+    if (!files.isEmpty()) {
+        return files.split(QLatin1Char(':'), Qt::SkipEmptyParts);
+    }
+    // Whatever the package manager rewrites on every (un)install
+    return {
+        QStringLiteral("/var/lib/dpkg/status"),
+        QStringLiteral("/var/lib/rpm"),
+        QStringLiteral("/usr/lib/sysimage/rpm"),
+        QStringLiteral("/var/lib/pacman/local"),
+        QStringLiteral("/lib/apk/db/installed"),
+        QStringLiteral("/var/db/pkg/local.sqlite"),
+    };
+}
+
+InstalledPackagesCache::InstalledPackagesCache()
+    : InstalledPackagesCache(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/appstreamhandler/installed.snapshot"))
+{
+}
+
+InstalledPackagesCache::InstalledPackagesCache(const QString &fileName)
+    : m_fileName(fileName)
+{
+}
+
+QByteArray InstalledPackagesCache::packageDatabaseFingerprint()
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    bool found = false;
+    for (const QString &path : packageDatabaseFiles()) {
+        QFileInfoList infos{QFileInfo(path)};
+        if (!infos.constFirst().exists()) {
+            continue;
+        }
+        found = true;
+        // Databases split over several files change some of them only
+        if (infos.constFirst().isDir()) {
+            infos += QDir(path).entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
+        }
+        for (const QFileInfo &info : std::as_const(infos)) {
+            hash.addData(info.absoluteFilePath().toUtf8());
+            hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+            hash.addData(QByteArray::number(info.size()));
+        }
+    }
+    // Without any known database we can't tell when the snapshot goes stale
+    return found ? hash.result().toHex() : QByteArray();
+}
+
+bool InstalledPackagesCache::load(const QByteArray &fingerprint)
+{
+    m_installed.clear();
+    if (fingerprint.isEmpty()) {
+        return false;
+    }
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 version;
+    stream >> version;
+    if (version != s_snapshotVersion) {
+        return false;
+    }
+    stream >> m_fingerprint;
+    if (m_fingerprint != fingerprint) {
+        qDebug() << "the package database changed, installed packages snapshot is outdated";
+        return false;
+    }
+    stream >> m_installed;
+    if (stream.status() != QDataStream::Ok) {
+        m_installed.clear();
+        return false;
+    }
+    return true;
+}
+
+bool InstalledPackagesCache::containsAll(const QStringList &packageNames) const
+{
+    if (packageNames.isEmpty()) {
+        return false;
+    }
+    return std::all_of(packageNames.cbegin(), packageNames.cend(), [this](const QString &packageName) {
+        return m_installed.contains(packageName);
+    });
+}
+
+bool InstalledPackagesCache::update(const QStringList &installed, const QStringList &notInstalled, const QByteArray &fingerprint)
+{
+    if (fingerprint.isEmpty()) {
+        return false;
+    }
+    if (fingerprint != m_fingerprint) {
+        // What we knew was true for another state of the database, only what was just reported can be trusted
+        m_installed.clear();
+        m_fingerprint = fingerprint;
+    }
+    for (const QString &packageName : notInstalled) {
+        m_installed.remove(packageName);
+    }
+    for (const QString &packageName : installed) {
+        m_installed.insert(packageName);
+    }
+
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "couldn't write the installed packages snapshot" << m_fileName << file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream << s_snapshotVersion << m_fingerprint << m_installed;
+    return file.commit();
+}
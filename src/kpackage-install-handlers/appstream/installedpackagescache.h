@@ -0,0 +1,52 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef INSTALLEDPACKAGESCACHE_H
+#define INSTALLEDPACKAGESCACHE_H
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Snapshot of the packages PackageKit reported as installed.
+ *
+ * It lets the handler answer requests for components that are present already
+ * without starting any PackageKit transaction. The snapshot is learned from the
+ * resolve transactions and stamped with a fingerprint of the package manager's
+ * database, any change to the database invalidates it.
+ */
+class InstalledPackagesCache
+{
+public:
+    /// Uses the default location in the user's cache directory
+    InstalledPackagesCache();
+    explicit InstalledPackagesCache(const QString &fileName);
+
+    /**
+     * Computes the fingerprint of the package manager's database.
+     * The files can be overridden with the colon separated APPSTREAMHANDLER_PACKAGE_DB.
+     */
+    static QByteArray packageDatabaseFingerprint();
+
+    /// Loads the snapshot, returns false if it doesn't exist or the database changed since
+    bool load(const QByteArray &fingerprint);
+
+    /// Whether all of @p packageNames are known to be installed
+    bool containsAll(const QStringList &packageNames) const;
+
+    /// Records the outcome of a resolve or install and saves the snapshot for @p fingerprint
+    bool update(const QStringList &installed, const QStringList &notInstalled, const QByteArray &fingerprint);
+
+private:
+    const QString m_fileName;
+    QByteArray m_fingerprint;
+    QSet<QString> m_installed;
+};
+
+#endif // INSTALLEDPACKAGESCACHE_H
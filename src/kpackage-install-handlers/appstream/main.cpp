@@ -7,79 +7,303 @@
 
 #include <AppStreamQt/pool.h>
 #include <PackageKit/Daemon>
+#include <QCommandLineParser>
 #include <QCoreApplication>
 #include <QDebug>
 
+#include <algorithm>
+#include <memory>
+
+#include "appstreamjobs.h"
+#include "componentindex.h"
+#include "handlerutils.h"
+#include "installedpackagescache.h"
+#include "installreport.h"
+#include "requestqueue.h"
+
 using namespace AppStream;
 
+struct ComponentRequest {
+    QString id;
+    QStringList packages;
+    bool installed = false;
+    bool alreadyInstalled = false;
+    bool missing = false;
+};
+
+static void printSummary(const QList<ComponentRequest> &requests)
+{
+    for (const ComponentRequest &request : requests) {
+        qInfo().noquote() << request.id
+                          << (request.alreadyInstalled ? "already installed"
+                                  : request.installed  ? "installed"
+                                  : request.missing    ? "not found"
+                                                       : "failed");
+    }
+}
+
 int main(int argc, char **argv)
 {
     QCoreApplication app(argc, argv);
-    Q_ASSERT(app.arguments().count() == 2);
 
-    const QUrl url(app.arguments().last());
-    Q_ASSERT(url.isValid());
-    Q_ASSERT(url.scheme() == QLatin1String("appstream"));
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Installs the packages of AppStream components from appstream:// links\n\n")
+                                     + KPackageHandler::exitCodeHelp());
+    parser.addHelpOption();
+    QCommandLineOption reportOption(QStringLiteral("report"),
+                                    QStringLiteral("Write a JSON report of the install phases to the file, \"-\" for stdout"),
+                                    QStringLiteral("file"));
+    parser.addOption(reportOption);
+    QCommandLineOption loadTimeoutOption(QStringLiteral("load-timeout"),
+                                         QStringLiteral("Seconds after which loading the AppStream catalog is given up"),
+                                         QStringLiteral("seconds"),
+                                         QStringLiteral("120"));
+    parser.addOption(loadTimeoutOption);
+    parser.addPositionalArgument(QStringLiteral("urls"), QStringLiteral("appstream:// links of the components to install"), QStringLiteral("urls..."));
+    parser.process(app);
 
-    const QString componentName = url.host();
-    if (componentName.isEmpty()) {
-        qWarning() << "wrongly formatted URI" << url;
-        return 1;
+    InstallReport report(QStringLiteral("appstreamhandler"));
+    if (parser.isSet(reportOption)) {
+        report.setOutputFile(parser.value(reportOption));
     }
+    report.setUrls(parser.positionalArguments());
 
-    Pool pool;
-    auto b = pool.load();
-    Q_ASSERT(b);
-    const auto components = pool.componentsById(componentName).toList();
-    if (components.isEmpty()) {
-        qWarning() << "couldn't find" << componentName;
-        return 1;
+    QList<QUrl> urls;
+    if (!KPackageHandler::parseUrls(parser, QStringLiteral("appstream"), &urls)) {
+        return report.finish(KPackageHandler::ExitInvalidArguments);
     }
-
-    QStringList packages;
-    for (const auto &component : components) {
-        packages += component.packageNames();
+    QList<ComponentRequest> requests;
+    for (const QUrl &url : std::as_const(urls)) {
+        requests << ComponentRequest{url.host(), {}};
     }
-    packages.removeDuplicates();
 
-    if (packages.isEmpty()) {
-        qWarning() << "no packages to install";
-        return 1;
+    const int loadTimeout = KPackageHandler::positiveIntValue(parser, loadTimeoutOption);
+    if (loadTimeout < 0) {
+        return report.finish(KPackageHandler::ExitInvalidArguments);
     }
 
-    auto resolveTransaction = PackageKit::Daemon::global()->resolve(packages, PackageKit::Transaction::FilterArch);
-    Q_ASSERT(resolveTransaction);
+    // Connecting to PackageKit activates the daemon, which can take a while, so do that while the catalog loads
+    PackageKit::Daemon::global();
+
+    // Catalog load, resolve and install run one after the other, each of them as a phase of the report
+    RequestQueue queue;
+    queue.setReport(&report);
 
     QHash<QString, QString> pkgs;
+    QStringList installedPackages;
+    QStringList availablePackages;
+    InstalledPackagesCache installedCache;
+    // Until the resolve finished, only components without any packages are known to be missing
+    bool lookupFinished = false;
 
-    QObject::connect(resolveTransaction,
-                     &PackageKit::Transaction::package,
-                     resolveTransaction,
-                     [&pkgs](PackageKit::Transaction::Info info, const QString &packageID, const QString & /*summary*/) {
-                         if (info == PackageKit::Transaction::InfoAvailable)
-                             pkgs[PackageKit::Daemon::packageName(packageID)] = packageID;
-                         qDebug() << "resolved package" << info << packageID;
-                     });
-    QObject::connect(resolveTransaction, &PackageKit::Transaction::finished, resolveTransaction, [&app, &pkgs](PackageKit::Transaction::Exit status) {
-        if (status != PackageKit::Transaction::ExitSuccess) {
-            qWarning() << "resolve failed" << status;
-            QCoreApplication::exit(1);
-            return;
+    // A component can be installed if PackageKit knows every one of its packages
+    const auto isResolved = [&pkgs, &installedPackages](const ComponentRequest &request) {
+        return !request.packages.isEmpty() && std::all_of(request.packages.cbegin(), request.packages.cend(), [&](const QString &packageName) {
+                   return pkgs.contains(packageName) || installedPackages.contains(packageName);
+               });
+    };
+
+    // Components whose packages all resolved are done, unless a step after the lookup failed with @p result
+    const auto finish = [&requests, &lookupFinished, isResolved](int result) {
+        bool allInstalled = true;
+        bool anyUnknown = false;
+        for (ComponentRequest &request : requests) {
+            request.missing = !request.alreadyInstalled && (request.packages.isEmpty() || (lookupFinished && !isResolved(request)));
+            request.installed = request.alreadyInstalled || (result == KPackageHandler::ExitSuccess && !request.missing);
+            allInstalled = allInstalled && request.installed;
+            anyUnknown = anyUnknown || request.missing;
         }
-        QStringList pkgids = pkgs.values();
+        printSummary(requests);
+        if (allInstalled) {
+            QCoreApplication::exit(KPackageHandler::ExitSuccess);
+        } else if (result != KPackageHandler::ExitSuccess) {
+            QCoreApplication::exit(result);
+        } else {
+            QCoreApplication::exit(anyUnknown ? KPackageHandler::ExitNotFound : KPackageHandler::ExitFailure);
+        }
+    };
 
+    const auto install = [&app, &queue, &requests, &pkgs, &installedPackages, &installedCache, isResolved, finish]() {
+        // Only whole components, the packages of a component missing some of them are left alone
+        QStringList pkgids;
+        QStringList packageNames;
+        for (const ComponentRequest &request : std::as_const(requests)) {
+            if (request.alreadyInstalled) {
+                continue;
+            }
+            if (!isResolved(request)) {
+                qWarning() << "couldn't resolve all packages of" << request.id << request.packages;
+                continue;
+            }
+            for (const QString &packageName : request.packages) {
+                if (pkgs.contains(packageName)) {
+                    pkgids << pkgs.value(packageName);
+                    packageNames << packageName;
+                }
+            }
+        }
         if (pkgids.isEmpty()) {
             qDebug() << "Nothing to install";
-            QCoreApplication::exit(0);
-        } else {
-            qDebug() << "installing..." << pkgids;
-            pkgids.removeDuplicates();
-            auto installTransaction = PackageKit::Daemon::global()->installPackages(pkgids);
-            QObject::connect(installTransaction, &PackageKit::Transaction::finished, &app, [](PackageKit::Transaction::Exit status) {
-                qDebug() << "install finished" << status;
-                QCoreApplication::exit(status == PackageKit::Transaction::ExitSuccess ? 0 : 1);
-            });
+            finish(KPackageHandler::ExitSuccess);
+            return;
         }
+        qDebug() << "installing..." << pkgids;
+        pkgids.removeDuplicates();
+        auto installJob = new TransactionJob(QStringLiteral("install"), [pkgids]() {
+            return PackageKit::Daemon::global()->installPackages(pkgids);
+        });
+        installJob->setDetail(pkgids.join(QLatin1Char(' ')));
+        QObject::connect(installJob, &HandlerJob::finished, &app, [&installedPackages, &installedCache, packageNames, finish](HandlerJob *job) {
+            if (job->exitCode() == KPackageHandler::ExitSuccess) {
+                // The install changed the database, start the snapshot for its new state
+                installedCache.update(installedPackages + packageNames, {}, InstalledPackagesCache::packageDatabaseFingerprint());
+            }
+            finish(job->exitCode());
+        });
+        queue.enqueue(installJob);
+    };
+
+    const auto resolveAndInstall = [&app, &queue, &requests, &pkgs, &installedPackages, &availablePackages, &installedCache, &lookupFinished, &report, finish,
+                                    install]() {
+        // Components whose packages are all installed already don't need PackageKit at all
+        const int precheckPhase = report.startPhase(QStringLiteral("installed-precheck"));
+        const QByteArray databaseFingerprint = InstalledPackagesCache::packageDatabaseFingerprint();
+        installedCache.load(databaseFingerprint);
+        QStringList packages;
+        bool anyMissing = false;
+        for (ComponentRequest &request : requests) {
+            request.alreadyInstalled = installedCache.containsAll(request.packages);
+            if (!request.alreadyInstalled) {
+                packages += request.packages;
+                anyMissing = true;
+            }
+        }
+        packages.removeDuplicates();
+        report.endPhase(precheckPhase, true);
+
+        if (!anyMissing) {
+            qDebug() << "all components are installed already";
+            finish(KPackageHandler::ExitSuccess);
+            return;
+        }
+        if (packages.isEmpty()) {
+            qWarning() << "no packages to install";
+            finish(KPackageHandler::ExitNotFound);
+            return;
+        }
+
+        // A single resolve and a single install transaction for all components, so that
+        // PackageKit only has to authorize and run the transaction once
+        auto resolveJob = new TransactionJob(QStringLiteral("resolve"), [packages, &pkgs, &installedPackages, &availablePackages]() {
+            auto resolveTransaction = PackageKit::Daemon::global()->resolve(packages, PackageKit::Transaction::FilterArch);
+            QObject::connect(resolveTransaction,
+                             &PackageKit::Transaction::package,
+                             resolveTransaction,
+                             [&pkgs, &installedPackages, &availablePackages](PackageKit::Transaction::Info info,
+                                                                             const QString &packageID,
+                                                                             const QString & /*summary*/) {
+                                 if (info == PackageKit::Transaction::InfoAvailable) {
+                                     pkgs[PackageKit::Daemon::packageName(packageID)] = packageID;
+                                     availablePackages << PackageKit::Daemon::packageName(packageID);
+                                 } else if (info == PackageKit::Transaction::InfoInstalled) {
+                                     installedPackages << PackageKit::Daemon::packageName(packageID);
+                                 }
+                                 qDebug() << "resolved package" << info << packageID;
+                             });
+            return resolveTransaction;
+        });
+        resolveJob->setDetail(packages.join(QLatin1Char(' ')));
+        QObject::connect(resolveJob,
+                         &HandlerJob::finished,
+                         &app,
+                         [&installedPackages, &availablePackages, &installedCache, &lookupFinished, databaseFingerprint, finish, install](HandlerJob *job) {
+                             // A failed resolve says nothing about the packages, the components are failed rather than not found
+                             if (job->exitCode() != KPackageHandler::ExitSuccess) {
+                                 qWarning().noquote() << "couldn't resolve the packages:" << static_cast<TransactionJob *>(job)->errorText();
+                                 finish(job->exitCode());
+                                 return;
+                             }
+                             lookupFinished = true;
+                             // A package with an update is reported both as installed and available
+                             QStringList notInstalled = availablePackages;
+                             notInstalled.removeIf([&installedPackages](const QString &packageName) {
+                                 return installedPackages.contains(packageName);
+                             });
+                             installedCache.update(installedPackages, notInstalled, databaseFingerprint);
+                             install();
+                         });
+        queue.enqueue(resolveJob);
+    };
+
+    // Fast path: take the package names from the index instead of loading the whole catalog
+    ComponentIndex index;
+    const QByteArray fingerprint = ComponentIndex::catalogFingerprint();
+    index.load(fingerprint);
+
+    bool needsPool = false;
+    for (ComponentRequest &request : requests) {
+        const int indexPhase = report.startPhase(QStringLiteral("index-lookup"), request.id);
+        request.packages = index.packageNames(request.id);
+        report.endPhase(indexPhase, !request.packages.isEmpty());
+        needsPool = needsPool || request.packages.isEmpty();
+    }
+
+    if (!needsPool) {
+        resolveAndInstall();
+        return report.finish(app.exec());
+    }
+
+    // Loaded only if the index doesn't know one of the components, and then only once for all of them.
+    // The load runs in the background, so that a hanging catalog can't block the caller forever.
+    auto pool = std::make_unique<Pool>();
+    ComponentIndex::applyCatalogOverride(*pool);
+    // A pool must not be destroyed while it is still loading in the background, e.g. after the load timed out
+    bool poolLoading = true;
+    QObject::connect(pool.get(), &Pool::loadFinished, &app, [&poolLoading]() {
+        poolLoading = false;
+    });
+    auto loadJob = new CatalogLoadJob(pool.get());
+    loadJob->setDeadline(loadTimeout * 1000);
+    QObject::connect(loadJob, &HandlerJob::finished, &app, [&](HandlerJob *job) {
+        if (job->exitCode() == KPackageHandler::ExitTimeout) {
+            qWarning() << "loading the AppStream catalog took longer than" << loadTimeout << "s, giving up";
+        }
+        if (job->exitCode() != KPackageHandler::ExitSuccess) {
+            finish(job->exitCode());
+            return;
+        }
+        if (!index.isValid()) {
+            index.rebuild(*pool, fingerprint);
+        }
+
+        for (ComponentRequest &request : requests) {
+            if (!request.packages.isEmpty()) {
+                continue;
+            }
+            const int lookupPhase = report.startPhase(QStringLiteral("components-by-id"), request.id);
+            const auto components = pool->componentsById(request.id).toList();
+            report.endPhase(lookupPhase, !components.isEmpty());
+            if (components.isEmpty()) {
+                qWarning() << "couldn't find" << request.id;
+                continue;
+            }
+
+            for (const auto &component : components) {
+                request.packages += component.packageNames();
+            }
+            request.packages.removeDuplicates();
+            if (request.packages.isEmpty()) {
+                qWarning() << "no packages to install for" << request.id;
+            }
+        }
+        resolveAndInstall();
     });
-    return app.exec();
+    queue.enqueue(loadJob);
+    const int exitCode = report.finish(app.exec());
+    if (poolLoading) {
+        // The process exits right away, which ends the load as well
+        qDebug() << "leaving the AppStream catalog load running";
+        (void)pool.release();
+    }
+    return exitCode;
 }
@@ -0,0 +1,85 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "handlerjob.h"
+
+HandlerJob::HandlerJob(const QString &name, QObject *parent)
+    : QObject(parent)
+    , m_name(name)
+{
+}
+
+QString HandlerJob::name() const
+{
+    return m_name;
+}
+
+void HandlerJob::setDetail(const QString &detail)
+{
+    m_detail = detail;
+}
+
+QString HandlerJob::detail() const
+{
+    return m_detail;
+}
+
+void HandlerJob::setDeadline(int msecs)
+{
+    m_deadline = msecs;
+}
+
+int HandlerJob::deadline() const
+{
+    return m_deadline;
+}
+
+qint64 HandlerJob::bytes() const
+{
+    return m_bytes;
+}
+
+void HandlerJob::setBytes(qint64 bytes)
+{
+    m_bytes = bytes;
+}
+
+bool HandlerJob::isFinished() const
+{
+    return m_finished;
+}
+
+int HandlerJob::exitCode() const
+{
+    return m_exitCode;
+}
+
+void HandlerJob::cancel(int exitCode)
+{
+    if (m_finished) {
+        return;
+    }
+    doCancel();
+    emitResult(exitCode);
+}
+
+void HandlerJob::doCancel()
+{
+}
+
+void HandlerJob::emitResult(int exitCode)
+{
+    // Late results of cancelled jobs are dropped
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_exitCode = exitCode;
+    Q_EMIT finished(this);
+}
+
+#include "moc_handlerjob.cpp"
@@ -0,0 +1,69 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef HANDLERJOB_H
+#define HANDLERJOB_H
+
+#include <QObject>
+#include <QString>
+
+class RequestQueue;
+
+/**
+ * A unit of work of an install handler, e.g. loading a catalog or installing a payload.
+ *
+ * Jobs are run by a RequestQueue, which also enforces their deadline and records
+ * them as phase, named after name(), in the install report.
+ */
+class HandlerJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HandlerJob(const QString &name, QObject *parent = nullptr);
+
+    QString name() const;
+
+    void setDetail(const QString &detail);
+    QString detail() const;
+
+    /// Milliseconds the job may run before it is cancelled with ExitTimeout, 0 for no deadline
+    void setDeadline(int msecs);
+    int deadline() const;
+
+    /// Bytes transferred or written by the job, -1 if unknown
+    qint64 bytes() const;
+
+    bool isFinished() const;
+    /// One of KPackageHandler::ExitCode
+    int exitCode() const;
+
+    /// Stops the job, it finishes with @p exitCode unless it is done already
+    void cancel(int exitCode);
+
+Q_SIGNALS:
+    void finished(HandlerJob *job);
+
+protected:
+    virtual void start() = 0;
+    /// Reimplement to abort the underlying work, the job finishes right after
+    virtual void doCancel();
+
+    void setBytes(qint64 bytes);
+    void emitResult(int exitCode);
+
+private:
+    friend class RequestQueue;
+
+    const QString m_name;
+    QString m_detail;
+    int m_deadline = 0;
+    qint64 m_bytes = -1;
+    int m_exitCode = 0;
+    bool m_finished = false;
+};
+
+#endif // HANDLERJOB_H
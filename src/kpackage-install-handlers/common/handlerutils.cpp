@@ -0,0 +1,64 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "handlerutils.h"
+
+#include <QCommandLineParser>
+#include <QDebug>
+
+namespace KPackageHandler
+{
+QString exitCodeHelp()
+{
+    return QStringLiteral(
+        "Exit codes:\n"
+        "  0  success\n"
+        "  1  the install failed\n"
+        "  2  a malformed link or option was passed\n"
+        "  3  what should be installed doesn't exist\n"
+        "  4  a request ran past its deadline\n"
+        "  5  the install was cancelled");
+}
+
+QUrl parseUrl(const QString &argument, const QString &scheme)
+{
+    const QUrl url(argument);
+    if (!url.isValid() || url.scheme() != scheme || url.host().isEmpty()) {
+        qWarning() << "wrongly formatted URI" << argument << "expected" << scheme + QLatin1String("://");
+        return QUrl();
+    }
+    return url;
+}
+
+bool parseUrls(const QCommandLineParser &parser, const QString &scheme, QList<QUrl> *urls)
+{
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.isEmpty()) {
+        qWarning() << "no" << scheme << "links passed";
+        return false;
+    }
+    for (const QString &argument : arguments) {
+        const QUrl url = parseUrl(argument, scheme);
+        if (url.isEmpty()) {
+            return false;
+        }
+        *urls << url;
+    }
+    return true;
+}
+
+int positiveIntValue(const QCommandLineParser &parser, const QCommandLineOption &option, int minimum)
+{
+    bool ok;
+    const int value = parser.value(option).toInt(&ok);
+    if (!ok || value < minimum) {
+        qWarning() << option.names().constFirst() << "must be an integer of at least" << minimum << parser.value(option);
+        return -1;
+    }
+    return value;
+}
+}
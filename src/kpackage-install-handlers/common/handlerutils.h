@@ -0,0 +1,59 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef HANDLERUTILS_H
+#define HANDLERUTILS_H
+
+#include <QStringList>
+#include <QUrl>
+
+class QCommandLineOption;
+class QCommandLineParser;
+
+namespace KPackageHandler
+{
+/**
+ * Exit codes shared by all the install handlers.
+ *
+ * 1 stays the generic failure, so callers which only check for a non zero code keep working.
+ * KPackage only distinguishes success from failure, the others are for tools driving the handlers.
+ */
+enum ExitCode {
+    ExitSuccess = 0,
+    ExitFailure = 1, ///< The install itself failed, or any failure not covered below
+    ExitInvalidArguments = 2, ///< A malformed link or option was passed
+    ExitNotFound = 3, ///< What should be installed doesn't exist
+    ExitTimeout = 4, ///< A request ran past its deadline
+    ExitCancelled = 5,
+};
+
+/// Describes the exit codes, to be shown by --help through QCommandLineParser::setApplicationDescription()
+QString exitCodeHelp();
+
+/**
+ * Parses @p argument as link with the given @p scheme and a non empty host.
+ *
+ * Returns an empty url and prints a warning if the link is malformed.
+ */
+QUrl parseUrl(const QString &argument, const QString &scheme);
+
+/**
+ * Parses all positional arguments of @p parser with parseUrl().
+ *
+ * Returns false if any of them is malformed or if there are none.
+ */
+bool parseUrls(const QCommandLineParser &parser, const QString &scheme, QList<QUrl> *urls);
+
+/**
+ * Reads the value of @p option as a number of at least @p minimum.
+ *
+ * Returns -1 and prints a warning if the value is not such a number.
+ */
+int positiveIntValue(const QCommandLineParser &parser, const QCommandLineOption &option, int minimum = 1);
+}
+
+#endif // HANDLERUTILS_H
@@ -0,0 +1,120 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "installreport.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+InstallReport::InstallReport(const QString &handlerName)
+    : m_handlerName(handlerName)
+    , m_outputFile(qEnvironmentVariable("KPACKAGE_HANDLER_REPORT"))
+{
+    m_timer.start();
+}
+
+void InstallReport::setOutputFile(const QString &fileName)
+{
+    m_outputFile = fileName;
+}
+
+bool InstallReport::isEnabled() const
+{
+    return !m_outputFile.isEmpty();
+}
+
+void InstallReport::setUrls(const QStringList &urls)
+{
+    m_urls = urls;
+}
+
+int InstallReport::startPhase(const QString &name, const QString &detail)
+{
+    if (!isEnabled()) {
+        return -1;
+    }
+    Phase phase;
+    phase.name = name;
+    phase.detail = detail;
+    phase.startNsecs = m_timer.nsecsElapsed();
+    m_phases << phase;
+    return m_phases.size() - 1;
+}
+
+void InstallReport::endPhase(int phase, bool success, qint64 bytes)
+{
+    if (phase < 0 || phase >= m_phases.size()) {
+        return;
+    }
+    Phase &p = m_phases[phase];
+    if (p.endNsecs >= 0) {
+        return;
+    }
+    p.endNsecs = m_timer.nsecsElapsed();
+    p.success = success;
+    p.bytes = bytes;
+}
+
+int InstallReport::finish(int exitCode)
+{
+    if (!isEnabled() || m_finished) {
+        return exitCode;
+    }
+    m_finished = true;
+
+    const auto msecs = [](qint64 nsecs) {
+        return nsecs / 1000000.0;
+    };
+
+    QJsonArray phases;
+    for (const Phase &phase : std::as_const(m_phases)) {
+        QJsonObject object{
+            {QStringLiteral("name"), phase.name},
+            {QStringLiteral("startMs"), msecs(phase.startNsecs)},
+        };
+        if (!phase.detail.isEmpty()) {
+            object.insert(QStringLiteral("detail"), phase.detail);
+        }
+        if (phase.endNsecs < 0) {
+            object.insert(QStringLiteral("outcome"), QStringLiteral("incomplete"));
+        } else {
+            object.insert(QStringLiteral("durationMs"), msecs(phase.endNsecs - phase.startNsecs));
+            object.insert(QStringLiteral("outcome"), phase.success ? QStringLiteral("success") : QStringLiteral("failure"));
+        }
+        if (phase.bytes >= 0) {
+            object.insert(QStringLiteral("bytes"), phase.bytes);
+        }
+        phases.append(object);
+    }
+
+    const QJsonObject report{
+        {QStringLiteral("handler"), m_handlerName},
+        {QStringLiteral("version"), QCoreApplication::applicationVersion()},
+        {QStringLiteral("urls"), QJsonArray::fromStringList(m_urls)},
+        {QStringLiteral("exitCode"), exitCode},
+        {QStringLiteral("totalMs"), msecs(m_timer.nsecsElapsed())},
+        {QStringLiteral("phases"), phases},
+    };
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Compact) + '\n';
+
+    QFile file;
+    bool opened;
+    if (m_outputFile == QLatin1String("-")) {
+        opened = file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        file.setFileName(m_outputFile);
+        opened = file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if (!opened || file.write(json) != json.size()) {
+        qWarning() << "couldn't write the install report to" << m_outputFile << file.errorString();
+    }
+    return exitCode;
+}
@@ -0,0 +1,62 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef INSTALLREPORT_H
+#define INSTALLREPORT_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Collects the timing of the phases an install handler goes through and writes
+ * them out as a JSON document, so that slow installs can be analyzed by tools.
+ *
+ * The report is opt-in: unless an output file has been set, nothing is written.
+ * Phases can overlap, e.g. when several payloads are downloaded at the same time.
+ */
+class InstallReport
+{
+public:
+    explicit InstallReport(const QString &handlerName);
+
+    /**
+     * Sets the file the report is written to, "-" writes it to stdout.
+     * Defaults to the value of the KPACKAGE_HANDLER_REPORT environment variable.
+     */
+    void setOutputFile(const QString &fileName);
+    bool isEnabled() const;
+
+    void setUrls(const QStringList &urls);
+
+    /// Returns an id to be passed to endPhase()
+    int startPhase(const QString &name, const QString &detail = QString());
+    void endPhase(int phase, bool success, qint64 bytes = -1);
+
+    /// Writes the report, returns @p exitCode so it can be used in return statements
+    int finish(int exitCode);
+
+private:
+    struct Phase {
+        QString name;
+        QString detail;
+        qint64 startNsecs = 0;
+        qint64 endNsecs = -1;
+        qint64 bytes = -1;
+        bool success = false;
+    };
+
+    const QString m_handlerName;
+    QString m_outputFile;
+    QStringList m_urls;
+    QElapsedTimer m_timer;
+    QList<Phase> m_phases;
+    bool m_finished = false;
+};
+
+#endif // INSTALLREPORT_H
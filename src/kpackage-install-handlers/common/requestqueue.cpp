@@ -0,0 +1,109 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "requestqueue.h"
+#include "handlerjob.h"
+#include "installreport.h"
+
+#include <QDebug>
+#include <QTimer>
+
+#include <utility>
+
+RequestQueue::RequestQueue(QObject *parent)
+    : QObject(parent)
+{
+}
+
+RequestQueue::~RequestQueue()
+{
+    qDeleteAll(m_queue);
+    qDeleteAll(m_running);
+}
+
+void RequestQueue::setMaxConcurrent(int maxConcurrent)
+{
+    m_maxConcurrent = qMax(1, maxConcurrent);
+    startNext();
+}
+
+int RequestQueue::maxConcurrent() const
+{
+    return m_maxConcurrent;
+}
+
+void RequestQueue::setReport(InstallReport *report)
+{
+    m_report = report;
+}
+
+void RequestQueue::enqueue(HandlerJob *job)
+{
+    job->setParent(this);
+    connect(job, &HandlerJob::finished, this, &RequestQueue::jobDone);
+    m_queue.enqueue(job);
+    startNext();
+}
+
+int RequestQueue::pendingCount() const
+{
+    return m_queue.size() + m_running.size();
+}
+
+void RequestQueue::cancelAll(int exitCode)
+{
+    // Queued jobs never started, they only have to report their result
+    const QQueue<HandlerJob *> queue = std::exchange(m_queue, {});
+    for (HandlerJob *job : queue) {
+        m_running << job;
+        job->cancel(exitCode);
+    }
+    const QList<HandlerJob *> running = m_running;
+    for (HandlerJob *job : running) {
+        job->cancel(exitCode);
+    }
+}
+
+void RequestQueue::startNext()
+{
+    while (m_running.size() < m_maxConcurrent && !m_queue.isEmpty()) {
+        HandlerJob *job = m_queue.dequeue();
+        m_running << job;
+
+        if (m_report) {
+            m_phases.insert(job, m_report->startPhase(job->name(), job->detail()));
+        }
+        if (job->deadline() > 0) {
+            QTimer::singleShot(job->deadline(), job, [job]() {
+                qWarning() << job->name() << job->detail() << "ran past its deadline of" << job->deadline() << "ms";
+                job->cancel(KPackageHandler::ExitTimeout);
+            });
+        }
+        Q_EMIT jobStarted(job);
+        job->start();
+    }
+}
+
+void RequestQueue::jobDone(HandlerJob *job)
+{
+    if (!m_running.removeOne(job)) {
+        return;
+    }
+    // Jobs cancelled before they started have no phase
+    if (m_report && m_phases.contains(job)) {
+        m_report->endPhase(m_phases.take(job), job->exitCode() == KPackageHandler::ExitSuccess, job->bytes());
+    }
+    Q_EMIT jobFinished(job);
+    job->deleteLater();
+
+    startNext();
+    if (m_queue.isEmpty() && m_running.isEmpty()) {
+        Q_EMIT idle();
+    }
+}
+
+#include "moc_requestqueue.cpp"
@@ -0,0 +1,66 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef REQUESTQUEUE_H
+#define REQUESTQUEUE_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QQueue>
+
+#include "handlerutils.h"
+
+class HandlerJob;
+class InstallReport;
+
+/**
+ * Runs HandlerJobs, at most maxConcurrent() of them at the same time and in the
+ * order they were enqueued.
+ *
+ * Jobs that run past their deadline are cancelled with ExitTimeout. If a report
+ * is set, every job is recorded in it as a phase.
+ */
+class RequestQueue : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RequestQueue(QObject *parent = nullptr);
+    ~RequestQueue() override;
+
+    void setMaxConcurrent(int maxConcurrent);
+    int maxConcurrent() const;
+
+    void setReport(InstallReport *report);
+
+    /// Takes ownership of @p job, it is deleted after jobFinished() was emitted
+    void enqueue(HandlerJob *job);
+
+    /// Number of jobs that are either queued or running
+    int pendingCount() const;
+
+    /// Cancels the running jobs and drops the queued ones, all of them finish with @p exitCode
+    void cancelAll(int exitCode = KPackageHandler::ExitCancelled);
+
+Q_SIGNALS:
+    void jobStarted(HandlerJob *job);
+    void jobFinished(HandlerJob *job);
+    /// Emitted whenever the last pending job finished
+    void idle();
+
+private:
+    void startNext();
+    void jobDone(HandlerJob *job);
+
+    int m_maxConcurrent = 1;
+    InstallReport *m_report = nullptr;
+    QQueue<HandlerJob *> m_queue;
+    QList<HandlerJob *> m_running;
+    QHash<HandlerJob *, int> m_phases;
+};
+
+#endif // REQUESTQUEUE_H
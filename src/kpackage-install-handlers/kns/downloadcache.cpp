@@ -0,0 +1,258 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "downloadcache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+
+/*
+    index.json:
+    {
+        "entries": { "<key>": { "sha256": "<hex>", "lastUsed": <msecs since epoch> } },
+        "blobs": { "<hex>": <size> }
+    }
+*/
+
+static const QLatin1String s_entries("entries");
+static const QLatin1String s_blobs("blobs");
+static const QLatin1String s_sha256("sha256");
+static const QLatin1String s_lastUsed("lastUsed");
+
+DownloadCache::DownloadCache(const QString &directory, qint64 maxSize)
+    : m_directory(directory)
+    , m_maxSize(maxSize)
+{
+    QDir().mkpath(downloadDirectory());
+    QDir().mkpath(m_directory + QLatin1String("/blobs"));
+}
+
+QString DownloadCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/knshandler/downloads");
+}
+
+bool DownloadCache::isCacheable(const KNSCore::Entry &entry)
+{
+    // Static providers are identified by the url of their provider file, OCS providers by their host
+    return !entry.payload().isEmpty() && !QUrl(entry.providerId()).scheme().isEmpty();
+}
+
+QString DownloadCache::key(const KNSCore::Entry &entry, quint8 linkId)
+{
+    // Updates install the new version, which is what the payload points to then
+    const QString version = entry.status() == KNSCore::Entry::Updateable ? entry.updateVersion() : entry.version();
+    const QString id = entry.providerId() + QLatin1Char('\n') + entry.uniqueId() + QLatin1Char('\n') + version + QLatin1Char('\n')
+        + QString::number(linkId) + QLatin1Char('\n') + entry.payload();
+    return QString::fromLatin1(QCryptographicHash::hash(id.toUtf8(), QCryptographicHash::Sha256).toHex());
+}
+
+QString DownloadCache::directory() const
+{
+    return m_directory;
+}
+
+qint64 DownloadCache::maxSize() const
+{
+    return m_maxSize;
+}
+
+QString DownloadCache::downloadDirectory() const
+{
+    return m_directory + QLatin1String("/partial");
+}
+
+int DownloadCache::hits() const
+{
+    return m_hits;
+}
+
+int DownloadCache::misses() const
+{
+    return m_misses;
+}
+
+QString DownloadCache::blobPath(const QString &sha256) const
+{
+    return m_directory + QLatin1String("/blobs/") + sha256;
+}
+
+QString DownloadCache::namedPath(const QString &key, const QString &blob, const QString &fileName) const
+{
+    const QString directory = m_directory + QLatin1String("/names/") + key;
+    const QString path = directory + QLatin1Char('/') + fileName;
+    const QFileInfo info(path);
+    if (info.isSymLink()) {
+        // The key may point to other content since the link was created, e.g. after a re-download
+        if (info.symLinkTarget() == QFileInfo(blob).absoluteFilePath()) {
+            return path;
+        }
+        QFile::remove(path);
+    }
+    if (!QDir().mkpath(directory) || !QFile::link(blob, path)) {
+        qWarning() << "could not link" << blob << "to" << path;
+        return QString();
+    }
+    return path;
+}
+
+QJsonObject DownloadCache::readIndex() const
+{
+    QFile file(m_directory + QLatin1String("/index.json"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+bool DownloadCache::writeIndex(const QJsonObject &index) const
+{
+    QSaveFile file(m_directory + QLatin1String("/index.json"));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "could not write the download cache index" << file.fileName() << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+QString DownloadCache::lookup(const QString &key, const QString &fileName)
+{
+    QLockFile lock(m_directory + QLatin1String("/index.lock"));
+    if (!lock.tryLock(5000)) {
+        qWarning() << "could not lock the download cache" << m_directory;
+        ++m_misses;
+        return QString();
+    }
+
+    QJsonObject index = readIndex();
+    QJsonObject entries = index.value(s_entries).toObject();
+    QJsonObject entry = entries.value(key).toObject();
+    const QString sha256 = entry.value(s_sha256).toString();
+    if (sha256.isEmpty()) {
+        ++m_misses;
+        return QString();
+    }
+
+    const QString path = blobPath(sha256);
+    if (!QFileInfo::exists(path)) {
+        // Removed behind our back, e.g. by a cache cleaner
+        entries.remove(key);
+        index.insert(s_entries, entries);
+        writeIndex(index);
+        ++m_misses;
+        return QString();
+    }
+
+    entry.insert(s_lastUsed, QDateTime::currentMSecsSinceEpoch());
+    entries.insert(key, entry);
+    index.insert(s_entries, entries);
+    writeIndex(index);
+    ++m_hits;
+    return namedPath(key, path, fileName);
+}
+
+QString DownloadCache::insert(const QString &key, const QString &fileName, const QString &file, const QByteArray &sha256)
+{
+    const qint64 size = QFileInfo(file).size();
+    if (size > m_maxSize) {
+        qDebug() << "not caching" << file << "it is larger than the download cache" << size << m_maxSize;
+        QFile::remove(file);
+        return QString();
+    }
+
+    QLockFile lock(m_directory + QLatin1String("/index.lock"));
+    if (!lock.tryLock(5000)) {
+        qWarning() << "could not lock the download cache" << m_directory;
+        QFile::remove(file);
+        return QString();
+    }
+
+    const QString hash = QString::fromLatin1(sha256.toHex());
+    const QString path = blobPath(hash);
+    if (QFileInfo::exists(path)) {
+        // Same content as a payload of another entry, share it
+        QFile::remove(file);
+    } else if (!QFile::rename(file, path)) {
+        qWarning() << "could not move" << file << "into the download cache" << path;
+        QFile::remove(file);
+        return QString();
+    }
+
+    QJsonObject index = readIndex();
+    QJsonObject entries = index.value(s_entries).toObject();
+    entries.insert(key, QJsonObject{{s_sha256, hash}, {s_lastUsed, QDateTime::currentMSecsSinceEpoch()}});
+    index.insert(s_entries, entries);
+    QJsonObject blobs = index.value(s_blobs).toObject();
+    blobs.insert(hash, size);
+    index.insert(s_blobs, blobs);
+
+    evict(&index);
+    writeIndex(index);
+    return QFileInfo::exists(path) ? namedPath(key, path, fileName) : QString();
+}
+
+void DownloadCache::evict(QJsonObject *index) const
+{
+    QJsonObject entries = index->value(s_entries).toObject();
+    QJsonObject blobs = index->value(s_blobs).toObject();
+
+    // A blob is as recently used as the most recently used entry referring to it
+    QHash<QString, qint64> blobLastUsed;
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        const QJsonObject entry = it->toObject();
+        qint64 &lastUsed = blobLastUsed[entry.value(s_sha256).toString()];
+        lastUsed = qMax(lastUsed, entry.value(s_lastUsed).toInteger());
+    }
+
+    qint64 total = 0;
+    for (auto it = blobs.begin(); it != blobs.end();) {
+        // Blobs no entry refers to anymore can go right away
+        if (!blobLastUsed.contains(it.key())) {
+            QFile::remove(blobPath(it.key()));
+            it = blobs.erase(it);
+        } else {
+            total += it->toInteger();
+            ++it;
+        }
+    }
+
+    while (total > m_maxSize && !blobs.isEmpty()) {
+        auto oldest = blobs.begin();
+        for (auto it = blobs.begin(); it != blobs.end(); ++it) {
+            if (blobLastUsed.value(it.key()) < blobLastUsed.value(oldest.key())) {
+                oldest = it;
+            }
+        }
+        const QString hash = oldest.key();
+        qDebug() << "evicting" << hash << "from the download cache";
+        total -= oldest->toInteger();
+        QFile::remove(blobPath(hash));
+        blobs.erase(oldest);
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->toObject().value(s_sha256).toString() == hash) {
+                QDir(m_directory + QLatin1String("/names/") + it.key()).removeRecursively();
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    index->insert(s_entries, entries);
+    index->insert(s_blobs, blobs);
+}
@@ -0,0 +1,86 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef DOWNLOADCACHE_H
+#define DOWNLOADCACHE_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+#include <KNSCore/Entry>
+
+/**
+ * Keeps downloaded payloads on disk, so that installing the same payload again,
+ * e.g. for another knsrc file, a second global theme or another user sharing the
+ * directory, doesn't download it again.
+ *
+ * Payloads are stored by the SHA-256 of their content, an index maps the
+ * provider, entry, version and link id of a payload to its content. Several
+ * entries serving the same file share a single copy. Once the stored payloads
+ * exceed maxSize(), the least recently used ones are removed.
+ *
+ * The index is locked while it is modified, several handlers can use the same
+ * directory at the same time.
+ */
+class DownloadCache
+{
+public:
+    DownloadCache(const QString &directory, qint64 maxSize);
+
+    static QString defaultDirectory();
+
+    /**
+     * Whether the payload of @p entry can be served from the cache.
+     *
+     * Only static providers install the payload link of the entry as is, OCS
+     * providers resolve a fresh download link for every install.
+     */
+    static bool isCacheable(const KNSCore::Entry &entry);
+
+    /// Identifies the payload by provider, entry, the version to install, link id and payload link
+    static QString key(const KNSCore::Entry &entry, quint8 linkId);
+
+    QString directory() const;
+    qint64 maxSize() const;
+
+    /**
+     * Returns the path of the cached payload for @p key or an empty string, a hit marks it as recently used.
+     *
+     * KNewStuff installs files under the name of their payload link, so the returned
+     * path ends in @p fileName.
+     */
+    QString lookup(const QString &key, const QString &fileName);
+
+    /**
+     * Moves the downloaded @p file with the content hash @p sha256 into the cache
+     * and evicts old payloads if necessary.
+     *
+     * Returns the path of the cached payload, ending in @p fileName, or an empty string if it could not be stored.
+     */
+    QString insert(const QString &key, const QString &fileName, const QString &file, const QByteArray &sha256);
+
+    /// Directory for downloads in progress, on the same file system as the cache
+    QString downloadDirectory() const;
+
+    int hits() const;
+    int misses() const;
+
+private:
+    QString blobPath(const QString &sha256) const;
+    QString namedPath(const QString &key, const QString &blob, const QString &fileName) const;
+    QJsonObject readIndex() const;
+    bool writeIndex(const QJsonObject &index) const;
+    void evict(QJsonObject *index) const;
+
+    const QString m_directory;
+    const qint64 m_maxSize;
+    int m_hits = 0;
+    int m_misses = 0;
+};
+
+#endif // DOWNLOADCACHE_H
@@ -0,0 +1,254 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "downloadscheduler.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTemporaryFile>
+
+#include <KNSCore/EngineBase>
+#include <KNSCore/Transaction>
+
+#include "downloadcache.h"
+#include "handlerjob.h"
+
+#include <memory>
+
+// KNewStuff records installed directories as "path/*"
+static qint64 installedSize(const QStringList &installedFiles)
+{
+    qint64 size = 0;
+    for (QString path : installedFiles) {
+        if (path.endsWith(QLatin1String("/*"))) {
+            path.chop(2);
+        }
+        const QFileInfo info(path);
+        if (info.isDir()) {
+            QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                size += it.nextFileInfo().size();
+            }
+        } else {
+            size += info.size();
+        }
+    }
+    return size;
+}
+
+/**
+ * Installs one payload of an entry, KNewStuff downloads and installs it in the same transaction.
+ *
+ * With a download cache the payload is looked up in the cache first, on a miss it is
+ * downloaded into the cache. Either way KNewStuff then installs the cached file.
+ */
+class InstallTransferJob : public HandlerJob
+{
+public:
+    InstallTransferJob(KNSCore::EngineBase *engine, DownloadCache *cache, QNetworkAccessManager *network, const KNSCore::Entry &entry, quint8 linkId)
+        : HandlerJob(QStringLiteral("download-install"))
+        , m_engine(engine)
+        , m_cache(cache)
+        , m_network(network)
+        , m_entry(entry)
+        , m_linkId(linkId)
+    {
+        setDetail(entry.uniqueId() + QLatin1String(" link ") + QString::number(linkId));
+    }
+
+    void start() override
+    {
+        m_timer.start();
+        if (!m_cache || !DownloadCache::isCacheable(m_entry)) {
+            install();
+            return;
+        }
+
+        const QString key = DownloadCache::key(m_entry, m_linkId);
+        const QString fileName = QUrl(m_entry.payload()).fileName();
+        const QString cachedFile = m_cache->lookup(key, fileName);
+        if (!cachedFile.isEmpty()) {
+            qDebug() << "using cached payload" << cachedFile << "for" << m_entry.uniqueId() << "link" << m_linkId;
+            useCachedFile(cachedFile);
+            install();
+            return;
+        }
+        fetchIntoCache(key, fileName);
+    }
+
+    // Lets KNewStuff install the cached copy instead of downloading the payload
+    void useCachedFile(const QString &cachedFile)
+    {
+        m_entry.setPayload(QUrl::fromLocalFile(cachedFile).toString());
+    }
+
+    void doCancel() override
+    {
+        if (m_reply) {
+            // Otherwise the aborted reply would fall back to installing without the cache
+            m_reply->disconnect(this);
+            m_reply->abort();
+            m_reply->deleteLater();
+        }
+    }
+
+    void fetchIntoCache(const QString &key, const QString &fileName)
+    {
+        auto file = new QTemporaryFile(m_cache->downloadDirectory() + QLatin1String("/XXXXXX"), this);
+        if (!file->open()) {
+            qWarning() << "could not create a file in the download cache" << m_cache->downloadDirectory() << file->errorString();
+            install();
+            return;
+        }
+
+        auto hash = std::make_shared<QCryptographicHash>(QCryptographicHash::Sha256);
+        const QUrl link(m_entry.payload());
+        m_reply = m_network->get(QNetworkRequest(link));
+        m_reply->setParent(this);
+        connect(m_reply, &QNetworkReply::readyRead, this, [this, file, hash]() {
+            const QByteArray data = m_reply->readAll();
+            hash->addData(data);
+            file->write(data);
+        });
+        connect(m_reply, &QNetworkReply::finished, this, [this, file, hash, key, fileName, link]() {
+            m_reply->deleteLater();
+            if (m_reply->error() != QNetworkReply::NoError || !file->flush()) {
+                // Let KNewStuff try on its own, it reports the error if that fails as well
+                qWarning() << "could not download" << link << "into the download cache" << m_reply->errorString();
+                install();
+                return;
+            }
+            file->setAutoRemove(false);
+            file->close();
+            const QString cachedFile = m_cache->insert(key, fileName, file->fileName(), hash->result());
+            if (!cachedFile.isEmpty()) {
+                useCachedFile(cachedFile);
+            }
+            install();
+        });
+    }
+
+    void install()
+    {
+        qDebug() << "installing..." << m_entry.uniqueId() << "link" << m_linkId;
+
+        auto transaction = KNSCore::Transaction::installLinkId(m_engine, m_entry, m_linkId);
+        connect(transaction,
+                &KNSCore::Transaction::signalErrorCode,
+                this,
+                [this](KNSCore::ErrorCode::ErrorCode errorCode, const QString &message, const QVariant &metadata) {
+                    m_errorCode = errorCode;
+                    m_errorMessage = message;
+                    m_errorMetadata = metadata;
+                    emitResult(KPackageHandler::ExitFailure);
+                });
+        connect(transaction, &KNSCore::Transaction::signalEntryEvent, this, [this](const KNSCore::Entry &entry, KNSCore::Entry::EntryEvent event) {
+            if (event == KNSCore::Entry::StatusChangedEvent && entry.status() == KNSCore::Entry::Installed) {
+                m_entry = entry;
+                setBytes(installedSize(entry.installedFiles()));
+                emitResult(KPackageHandler::ExitSuccess);
+            }
+        });
+    }
+
+    KNSCore::EngineBase *const m_engine;
+    DownloadCache *const m_cache;
+    QNetworkAccessManager *const m_network;
+    QPointer<QNetworkReply> m_reply;
+    KNSCore::Entry m_entry;
+    const quint8 m_linkId;
+    QElapsedTimer m_timer;
+
+    KNSCore::ErrorCode::ErrorCode m_errorCode = KNSCore::ErrorCode::UnknownError;
+    QString m_errorMessage;
+    QVariant m_errorMetadata;
+};
+
+DownloadScheduler::DownloadScheduler(KNSCore::EngineBase *engine, QObject *parent)
+    : QObject(parent)
+    , m_engine(engine)
+{
+    connect(&m_queue, &RequestQueue::jobStarted, this, [this](HandlerJob *job) {
+        auto transfer = static_cast<InstallTransferJob *>(job);
+        Q_EMIT transferStarted(transfer->m_entry, transfer->m_linkId);
+    });
+    connect(&m_queue, &RequestQueue::jobFinished, this, [this](HandlerJob *job) {
+        auto transfer = static_cast<InstallTransferJob *>(job);
+        switch (job->exitCode()) {
+        case KPackageHandler::ExitSuccess: {
+            const qint64 msecs = transfer->m_timer.elapsed();
+            m_totalBytes += job->bytes();
+            qDebug() << "installed" << transfer->m_entry.uniqueId() << "link" << transfer->m_linkId << job->bytes() << "bytes in" << msecs << "ms";
+            Q_EMIT transferFinished(transfer->m_entry, transfer->m_linkId, job->bytes(), msecs);
+            break;
+        }
+        case KPackageHandler::ExitFailure:
+            Q_EMIT transferFailed(transfer->m_errorCode, transfer->m_errorMessage, transfer->m_errorMetadata);
+            break;
+        default:
+            // Dropped by abort()
+            break;
+        }
+    });
+    connect(&m_queue, &RequestQueue::idle, this, [this]() {
+        if (!m_totalTimer.isValid()) {
+            return;
+        }
+        const qint64 totalMsecs = qMax<qint64>(1, m_totalTimer.elapsed());
+        qDebug() << "installed" << m_totalBytes << "bytes in" << totalMsecs << "ms," << (m_totalBytes * 1000 / totalMsecs) << "bytes/s";
+        m_totalBytes = 0;
+        m_totalTimer.invalidate();
+        Q_EMIT finished();
+    });
+}
+
+void DownloadScheduler::setMaxConcurrent(int maxConcurrent)
+{
+    m_queue.setMaxConcurrent(maxConcurrent);
+}
+
+int DownloadScheduler::maxConcurrent() const
+{
+    return m_queue.maxConcurrent();
+}
+
+void DownloadScheduler::setReport(InstallReport *report)
+{
+    m_queue.setReport(report);
+}
+
+void DownloadScheduler::setDownloadCache(DownloadCache *cache)
+{
+    m_cache = cache;
+}
+
+int DownloadScheduler::pendingCount() const
+{
+    return m_queue.pendingCount();
+}
+
+void DownloadScheduler::enqueue(const KNSCore::Entry &entry, quint8 linkId)
+{
+    if (!m_totalTimer.isValid()) {
+        m_totalTimer.start();
+    }
+    m_queue.enqueue(new InstallTransferJob(m_engine, m_cache, &m_network, entry, linkId));
+}
+
+void DownloadScheduler::abort()
+{
+    // Nobody waits for the transfers anymore, so don't report them either
+    m_totalTimer.invalidate();
+    m_totalBytes = 0;
+    m_queue.cancelAll();
+}
+
+#include "moc_downloadscheduler.cpp"
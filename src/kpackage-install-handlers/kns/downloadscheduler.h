@@ -0,0 +1,72 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef DOWNLOADSCHEDULER_H
+#define DOWNLOADSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QObject>
+
+#include <KNSCore/Entry>
+#include <KNSCore/ErrorCode>
+
+#include "requestqueue.h"
+
+namespace KNSCore
+{
+class EngineBase;
+}
+class DownloadCache;
+
+/**
+ * Runs the install transactions requested by the handler, at most
+ * maxConcurrent() of them at the same time.
+ *
+ * Every enqueued transfer counts as a pending install until its entry reaches
+ * the Installed state, once no install is pending anymore finished() is emitted.
+ */
+class DownloadScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DownloadScheduler(KNSCore::EngineBase *engine, QObject *parent = nullptr);
+
+    void setMaxConcurrent(int maxConcurrent);
+    int maxConcurrent() const;
+
+    /// Records every transfer as download-install phase into @p report
+    void setReport(InstallReport *report);
+
+    /// Serves payloads from @p cache and stores downloaded ones in it, nullptr disables caching
+    void setDownloadCache(DownloadCache *cache);
+
+    void enqueue(const KNSCore::Entry &entry, quint8 linkId);
+
+    /// Drops all queued transfers and forgets about the running ones
+    void abort();
+
+    /// Number of transfers that are either queued or running
+    int pendingCount() const;
+
+Q_SIGNALS:
+    void transferStarted(const KNSCore::Entry &entry, quint8 linkId);
+    void transferFinished(const KNSCore::Entry &entry, quint8 linkId, qint64 bytes, qint64 msecs);
+    void transferFailed(KNSCore::ErrorCode::ErrorCode errorCode, const QString &message, const QVariant &metadata);
+    void finished();
+
+private:
+    KNSCore::EngineBase *const m_engine;
+    RequestQueue m_queue;
+    DownloadCache *m_cache = nullptr;
+    QNetworkAccessManager m_network;
+
+    QElapsedTimer m_totalTimer;
+    qint64 m_totalBytes = 0;
+};
+
+#endif // DOWNLOADSCHEDULER_H
@@ -0,0 +1,41 @@
+# Installs all entries of the offline fixture into a fresh home directory and
+# prints the throughput taken from the handler's JSON report.
+#
+# cmake -DHANDLER=<knshandlertest> -DHOME_DIR=<dir> -DREPORT=<file> -DMAX_DOWNLOADS=<n> -DURLS=<url|url|...> -P knshandlerbenchmark.cmake
+
+string(REPLACE "|" ";" URLS "${URLS}")
+
+file(REMOVE_RECURSE "${HOME_DIR}")
+file(MAKE_DIRECTORY "${HOME_DIR}")
+set(ENV{HOME} "${HOME_DIR}")
+
+execute_process(COMMAND "${HANDLER}" --max-downloads ${MAX_DOWNLOADS} --report "${REPORT}" ${URLS}
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "knshandler failed with ${result}")
+endif()
+
+file(READ "${REPORT}" report)
+string(JSON totalMs GET "${report}" totalMs)
+string(JSON phaseCount LENGTH "${report}" phases)
+
+set(payloads 0)
+set(bytes 0)
+math(EXPR lastPhase "${phaseCount} - 1")
+foreach(i RANGE ${lastPhase})
+    string(JSON name GET "${report}" phases ${i} name)
+    string(JSON outcome GET "${report}" phases ${i} outcome)
+    if(name STREQUAL "download-install" AND outcome STREQUAL "success")
+        string(JSON phaseBytes GET "${report}" phases ${i} bytes)
+        math(EXPR payloads "${payloads} + 1")
+        math(EXPR bytes "${bytes} + ${phaseBytes}")
+    endif()
+endforeach()
+
+string(REGEX REPLACE "\\..*" "" totalMsInt "${totalMs}")
+if(totalMsInt LESS 1)
+    set(totalMsInt 1)
+endif()
+math(EXPR bytesPerSecond "${bytes} * 1000 / ${totalMsInt}")
+math(EXPR payloadsPerSecond "${payloads} * 1000 / ${totalMsInt}")
+message("knshandler benchmark: ${payloads} payloads, ${bytes} bytes in ${totalMs} ms (${payloadsPerSecond} payloads/s, ${bytesPerSecond} bytes/s, ${MAX_DOWNLOADS} parallel downloads)")
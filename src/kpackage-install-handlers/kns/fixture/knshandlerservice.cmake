@@ -0,0 +1,43 @@
+# Starts the service and sends it two requests for a knsrc file whose providers
+# can't be loaded. Both have to be answered with a failure right away, the
+# second one must not wait for the providers of the failed first one.
+#
+# cmake -DSERVICE=<knshandlertest> -DCLIENT=<knshandler> -DHOME_DIR=<dir> -DRUNTIME_DIR=<dir> -DURL=<kns url> -P knshandlerservice.cmake
+
+if(CLIENT_MODE)
+    # Wait for the service to listen, a client without a service would install locally
+    foreach(i RANGE 100)
+        if(EXISTS "${RUNTIME_DIR}/kpackage-knshandler.socket")
+            break()
+        endif()
+        execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 0.1)
+    endforeach()
+    if(NOT EXISTS "${RUNTIME_DIR}/kpackage-knshandler.socket")
+        message(FATAL_ERROR "the knshandler service didn't start listening")
+    endif()
+
+    foreach(request 1 2)
+        execute_process(COMMAND "${CLIENT}" "${URL}" RESULT_VARIABLE result TIMEOUT 30)
+        if(NOT result EQUAL 1)
+            message(FATAL_ERROR "request ${request} returned \"${result}\" instead of failing")
+        endif()
+    endforeach()
+    return()
+endif()
+
+file(REMOVE_RECURSE "${HOME_DIR}" "${RUNTIME_DIR}")
+file(MAKE_DIRECTORY "${HOME_DIR}" "${RUNTIME_DIR}")
+file(CHMOD "${RUNTIME_DIR}" DIRECTORY_PERMISSIONS OWNER_READ OWNER_WRITE OWNER_EXECUTE)
+set(ENV{HOME} "${HOME_DIR}")
+set(ENV{XDG_RUNTIME_DIR} "${RUNTIME_DIR}")
+
+# The commands of a pipeline run at the same time, the service quits once the client is done
+execute_process(
+    COMMAND "${SERVICE}" --service --idle-timeout 2
+    COMMAND ${CMAKE_COMMAND} -DCLIENT_MODE=ON "-DCLIENT=${CLIENT}" "-DRUNTIME_DIR=${RUNTIME_DIR}" "-DURL=${URL}" -P "${CMAKE_CURRENT_LIST_FILE}"
+    RESULTS_VARIABLE results
+    TIMEOUT 120
+)
+if(NOT results STREQUAL "0;0")
+    message(FATAL_ERROR "service and client returned \"${results}\"")
+endif()
@@ -0,0 +1,36 @@
+# Measures the time from starting the handler until its engine is initialized.
+# The first run starts in a fresh home directory and has to build the knsrc index,
+# the following ones use it.
+#
+# cmake -DHANDLER=<knshandlertest> -DHOME_DIR=<dir> -DRUNS=<n> -DURL=<kns url> -P knshandlerstartupbenchmark.cmake
+
+file(REMOVE_RECURSE "${HOME_DIR}")
+file(MAKE_DIRECTORY "${HOME_DIR}")
+set(ENV{HOME} "${HOME_DIR}")
+
+# Sets @p outVar to the wall clock time of one handler run in microseconds
+function(time_run outVar)
+    string(TIMESTAMP start "%s%f")
+    execute_process(COMMAND "${HANDLER}" --exit-after-init "${URL}" RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+    string(TIMESTAMP end "%s%f")
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "knshandler failed with ${result}")
+    endif()
+    math(EXPR elapsed "${end} - ${start}")
+    set(${outVar} ${elapsed} PARENT_SCOPE)
+endfunction()
+
+time_run(cold)
+
+set(total 0)
+set(min -1)
+foreach(i RANGE 1 ${RUNS})
+    time_run(elapsed)
+    math(EXPR total "${total} + ${elapsed}")
+    if(min LESS 0 OR elapsed LESS min)
+        set(min ${elapsed})
+    endif()
+endforeach()
+math(EXPR average "${total} / ${RUNS}")
+
+message("knshandler startup benchmark: first start ${cold} us, warm starts ${average} us on average, ${min} us at best (${RUNS} runs)")
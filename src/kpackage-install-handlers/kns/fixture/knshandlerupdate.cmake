@@ -0,0 +1,53 @@
+# Installs two entries of the update fixture, publishes a new version of one of
+# them and checks that --update finds and installs exactly that one.
+#
+# cmake -DHANDLER=<knshandlertest> -DHOME_DIR=<dir> -DFIXTURE_DIR=<dir> -DURL=<kns url without entry id> -P knshandlerupdate.cmake
+
+file(REMOVE_RECURSE "${HOME_DIR}")
+file(MAKE_DIRECTORY "${HOME_DIR}")
+set(ENV{HOME} "${HOME_DIR}")
+
+# Writes the provider's entries, entry 1 in version @p version1, entry 2 always in 1.0
+function(publish version1)
+    set(xml "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<knewstuff>\n")
+    foreach(i 1 2)
+        set(version 1.0)
+        set(date 2026-01-01)
+        if(i EQUAL 1 AND NOT version1 STREQUAL "1.0")
+            set(version ${version1})
+            set(date 2026-02-01)
+        endif()
+        set(entry "knshandler-update-${i}")
+        file(WRITE "${FIXTURE_DIR}/payloads/${entry}-${version}.txt" "${entry} ${version}\n")
+        string(APPEND xml
+            "  <stuff category=\"knshandler-fixture\">\n"
+            "    <name>${entry}</name>\n"
+            "    <id>${entry}</id>\n"
+            "    <version>${version}</version>\n"
+            "    <releasedate>${date}</releasedate>\n"
+            "    <payload>file://${FIXTURE_DIR}/payloads/${entry}-${version}.txt</payload>\n"
+            "  </stuff>\n")
+    endforeach()
+    string(APPEND xml "</knewstuff>\n")
+    file(WRITE "${FIXTURE_DIR}/entries.xml" "${xml}")
+endfunction()
+
+function(run_handler expectedOutput)
+    execute_process(COMMAND "${HANDLER}" ${ARGN} OUTPUT_VARIABLE output RESULT_VARIABLE result)
+    message("${output}")
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "knshandler ${ARGN} failed with ${result}")
+    endif()
+    if(expectedOutput AND NOT output MATCHES "${expectedOutput}")
+        message(FATAL_ERROR "knshandler ${ARGN} did not print \"${expectedOutput}\"")
+    endif()
+endfunction()
+
+publish(1.0)
+run_handler("" "${URL}/knshandler-update-1" "${URL}/knshandler-update-2")
+run_handler("2 installed, 0 updatable" --update knshandler-fixture-update.knsrc --check-updates)
+
+publish(2.0)
+run_handler("2 installed, 1 updatable\n  updatable knshandler-update-1" --update knshandler-fixture-update.knsrc --check-updates)
+run_handler("2 installed, 1 updatable, 1 updated, 0 skipped, 0 failed" --update knshandler-fixture-update.knsrc)
+run_handler("2 installed, 0 updatable" --update knshandler-fixture-update.knsrc --check-updates)
@@ -0,0 +1,216 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "knshandlerservice.h"
+#include "handlerutils.h"
+#include "knsinstaller.h"
+
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QLocalSocket>
+#include <QStandardPaths>
+
+// How long a forwarded install may take before it is done locally instead
+static const int s_forwardTimeout = 10 * 60 * 1000;
+
+KnsHandlerService::KnsHandlerService(QObject *parent)
+    : QObject(parent)
+{
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+    connect(&m_server, &QLocalServer::newConnection, this, &KnsHandlerService::newConnection);
+
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(5 * 60 * 1000);
+    connect(&m_idleTimer, &QTimer::timeout, this, []() {
+        qDebug() << "idle timeout reached, quitting";
+        QCoreApplication::exit(KPackageHandler::ExitSuccess);
+    });
+}
+
+QString KnsHandlerService::socketName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + QLatin1String("/kpackage-knshandler.socket");
+}
+
+int KnsHandlerService::forwardToService(const QStringList &urls)
+{
+    QLocalSocket socket;
+    socket.connectToServer(socketName());
+    if (!socket.waitForConnected(100)) {
+        return -1;
+    }
+
+    QByteArrayList request;
+    for (const QString &url : urls) {
+        request << QUrl(url).toEncoded();
+    }
+    socket.write(request.join(' ') + '\n');
+
+    // Installs can take a while, but a service that doesn't answer at all must not block us forever
+    const QDeadlineTimer deadline(s_forwardTimeout);
+    while (!socket.canReadLine()) {
+        if (!socket.waitForReadyRead(deadline.remainingTime())) {
+            qWarning() << "no answer from the knshandler service, installing locally" << socket.errorString();
+            return -1;
+        }
+    }
+    bool ok;
+    const int exitCode = socket.readLine().trimmed().toInt(&ok);
+    return ok ? exitCode : KPackageHandler::ExitFailure;
+}
+
+bool KnsHandlerService::listen()
+{
+    // A socket left behind by a crashed service would make listen() fail
+    QLocalServer::removeServer(socketName());
+    if (!m_server.listen(socketName())) {
+        qWarning() << "couldn't listen on" << socketName() << m_server.errorString();
+        return false;
+    }
+    qDebug() << "listening on" << m_server.fullServerName();
+    updateIdleTimer();
+    return true;
+}
+
+void KnsHandlerService::setIdleTimeout(int msecs)
+{
+    m_idleTimer.setInterval(msecs);
+    updateIdleTimer();
+}
+
+int KnsHandlerService::idleTimeout() const
+{
+    return m_idleTimer.interval();
+}
+
+void KnsHandlerService::setMaxDownloads(int maxDownloads)
+{
+    m_maxDownloads = maxDownloads;
+    for (KnsInstaller *installer : std::as_const(m_installers)) {
+        installer->setMaxDownloads(maxDownloads);
+    }
+}
+
+void KnsHandlerService::setDownloadCache(DownloadCache *cache)
+{
+    m_downloadCache = cache;
+    for (KnsInstaller *installer : std::as_const(m_installers)) {
+        installer->setDownloadCache(cache);
+    }
+}
+
+void KnsHandlerService::newConnection()
+{
+    while (QLocalSocket *socket = m_server.nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            if (socket->canReadLine()) {
+                handleRequest(socket, socket->readLine().trimmed());
+            }
+        });
+    }
+}
+
+void KnsHandlerService::handleRequest(QLocalSocket *socket, const QByteArray &request)
+{
+    QString knsHost;
+    QList<InstallTarget> targets;
+    for (const QByteArray &encodedUrl : request.split(' ')) {
+        if (encodedUrl.isEmpty()) {
+            continue;
+        }
+        QString urlHost;
+        InstallTarget target;
+        if (!parseInstallUrl(QUrl::fromEncoded(encodedUrl), &urlHost, &target)) {
+            reply(socket, KPackageHandler::ExitInvalidArguments);
+            return;
+        }
+        if (!knsHost.isEmpty() && knsHost != urlHost) {
+            qWarning() << "all urls need to use the same knsrc file" << knsHost << urlHost;
+            reply(socket, KPackageHandler::ExitInvalidArguments);
+            return;
+        }
+        knsHost = urlHost;
+        targets << target;
+    }
+
+    if (targets.isEmpty()) {
+        qWarning() << "no kns links passed";
+        reply(socket, KPackageHandler::ExitInvalidArguments);
+        return;
+    }
+    const QString knsrcFile = findKnsrcFile(knsHost);
+    if (knsrcFile.isEmpty()) {
+        qWarning() << "couldn't find knsrc file for" << knsHost;
+        reply(socket, KPackageHandler::ExitNotFound);
+        return;
+    }
+
+    KnsInstaller *knsInstaller = installer(knsrcFile);
+    if (!knsInstaller) {
+        reply(socket, KPackageHandler::ExitFailure);
+        return;
+    }
+    m_waitingSockets[knsInstaller].enqueue(socket);
+    knsInstaller->install(targets);
+    updateIdleTimer();
+}
+
+void KnsHandlerService::reply(QLocalSocket *socket, int exitCode)
+{
+    if (socket) {
+        socket->write(QByteArray::number(exitCode) + '\n');
+        socket->disconnectFromServer();
+    }
+}
+
+KnsInstaller *KnsHandlerService::installer(const QString &knsrcFile)
+{
+    if (KnsInstaller *knsInstaller = m_installers.value(knsrcFile)) {
+        return knsInstaller;
+    }
+
+    auto knsInstaller = new KnsInstaller(knsrcFile, this);
+    knsInstaller->setMaxDownloads(m_maxDownloads);
+    knsInstaller->setDownloadCache(m_downloadCache);
+    connect(knsInstaller, &KnsInstaller::finished, this, [this, knsInstaller](int exitCode) {
+        QQueue<QPointer<QLocalSocket>> &sockets = m_waitingSockets[knsInstaller];
+        if (!sockets.isEmpty()) {
+            reply(sockets.dequeue(), exitCode);
+        }
+        updateIdleTimer();
+    });
+    if (!knsInstaller->init() || knsInstaller->hasFailed()) {
+        qWarning() << "couldn't initialize" << knsrcFile;
+        delete knsInstaller;
+        return nullptr;
+    }
+    // Its waiting requests are answered already, drop it so that the next request tries to load the providers again
+    connect(knsInstaller, &KnsInstaller::failed, this, [this, knsrcFile, knsInstaller]() {
+        m_installers.remove(knsrcFile);
+        m_waitingSockets.remove(knsInstaller);
+        knsInstaller->deleteLater();
+        updateIdleTimer();
+    });
+    m_installers.insert(knsrcFile, knsInstaller);
+    return knsInstaller;
+}
+
+void KnsHandlerService::updateIdleTimer()
+{
+    const bool busy = std::any_of(m_installers.cbegin(), m_installers.cend(), [](KnsInstaller *knsInstaller) {
+        return knsInstaller->isBusy();
+    });
+    if (busy) {
+        m_idleTimer.stop();
+    } else {
+        m_idleTimer.start();
+    }
+}
+
+#include "moc_knshandlerservice.cpp"
@@ -0,0 +1,72 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef KNSHANDLERSERVICE_H
+#define KNSHANDLERSERVICE_H
+
+#include <QHash>
+#include <QLocalServer>
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QTimer>
+
+class DownloadCache;
+class KnsInstaller;
+class QLocalSocket;
+
+/**
+ * Resident mode of the knshandler.
+ *
+ * Listens on a local socket for install requests, so that back-to-back installs
+ * reuse the already initialized engines and providers instead of starting a new
+ * process for every kns:// link. A request is a single line with the
+ * space separated links, the reply is a line with the exit code of the install.
+ *
+ * The service quits once it hasn't processed any request for idleTimeout() msecs.
+ */
+class KnsHandlerService : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KnsHandlerService(QObject *parent = nullptr);
+
+    static QString socketName();
+
+    /**
+     * Sends the @p urls to a running service and waits for it to install them.
+     *
+     * Returns the exit code of the install or -1 if there is no service to talk to
+     * or it didn't answer in time, in which case the urls should be installed locally.
+     */
+    static int forwardToService(const QStringList &urls);
+
+    bool listen();
+
+    void setIdleTimeout(int msecs);
+    int idleTimeout() const;
+
+    void setMaxDownloads(int maxDownloads);
+    void setDownloadCache(DownloadCache *cache);
+
+private:
+    void newConnection();
+    void handleRequest(QLocalSocket *socket, const QByteArray &request);
+    void reply(QLocalSocket *socket, int exitCode);
+    KnsInstaller *installer(const QString &knsrcFile);
+    void updateIdleTimer();
+
+    QLocalServer m_server;
+    QTimer m_idleTimer;
+    int m_maxDownloads = 1;
+    DownloadCache *m_downloadCache = nullptr;
+    QHash<QString, KnsInstaller *> m_installers;
+    // Installers answer their requests in order, these are the sockets waiting for them
+    QHash<KnsInstaller *, QQueue<QPointer<QLocalSocket>>> m_waitingSockets;
+};
+
+#endif // KNSHANDLERSERVICE_H
@@ -0,0 +1,235 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "knsinstaller.h"
+#include "handlerutils.h"
+#include "installreport.h"
+#include "knsrcindex.h"
+
+#include <QDebug>
+#include <QUrlQuery>
+
+#include <KNSCore/ResultsStream>
+#include <KNSCore/SearchRequest>
+
+#include <memory>
+
+bool parseInstallUrl(const QUrl &url, QString *knsHost, InstallTarget *target)
+{
+    if (!url.isValid() || url.scheme() != QLatin1String("kns") || url.host().isEmpty()) {
+        qWarning() << "not a kns url" << url;
+        return false;
+    }
+    *knsHost = url.host();
+
+    // Provider ids can contain slashes, e.g. the download url of static providers, those have to be percent encoded
+    const auto pathParts = url.path(QUrl::FullyEncoded).split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    if (pathParts.size() != 2) {
+        qWarning() << "wrong format in the url path" << url << pathParts;
+        return false;
+    }
+    *target = InstallTarget{QUrl::fromPercentEncoding(pathParts.at(0).toUtf8()), QUrl::fromPercentEncoding(pathParts.at(1).toUtf8()), {}};
+    if (url.hasQuery()) {
+        // Several payloads of the same entry can be requested with either "linkid=1,2" or "linkid=1&linkid=2"
+        QUrlQuery query(url);
+        for (const QString &value : query.allQueryItemValues(QStringLiteral("linkid"))) {
+            for (const QString &linkIdString : value.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+                bool ok;
+                const int linkid = linkIdString.toInt(&ok);
+                if (!ok) {
+                    qWarning() << "linkid is not an integer" << url << pathParts;
+                    return false;
+                }
+                if (linkid < 0 || linkid > 255) {
+                    qWarning() << "linkid" << linkid << "is out of range, it has to be between 0 and 255" << url;
+                    return false;
+                }
+                target->linkIds << linkid;
+            }
+        }
+    }
+    if (target->linkIds.isEmpty()) {
+        target->linkIds << 1;
+    }
+    return true;
+}
+
+QString findKnsrcFile(const QString &knsHost)
+{
+    return KnsrcIndex().find(knsHost);
+}
+
+KnsInstaller::KnsInstaller(const QString &knsrcFile, QObject *parent)
+    : QObject(parent)
+    , m_knsrcFile(knsrcFile)
+    , m_scheduler(&m_engine)
+{
+    const auto onError = [this](KNSCore::ErrorCode::ErrorCode errorCode, const QString &message, const QVariant &metadata) {
+        qWarning() << "kns error:" << errorCode << message << metadata;
+        if (m_providersLoaded) {
+            if (m_requestRunning) {
+                finishRequest(KPackageHandler::ExitFailure);
+            }
+            return;
+        }
+        if (m_failed) {
+            return;
+        }
+        // The engine failed before it could process anything, neither the waiting nor any later request can succeed
+        m_failed = true;
+        if (m_report) {
+            m_report->endPhase(m_providerLoadPhase, false);
+        }
+        while (!m_requests.isEmpty()) {
+            m_requests.dequeue();
+            Q_EMIT finished(KPackageHandler::ExitFailure);
+        }
+        Q_EMIT failed();
+    };
+    connect(&m_engine, &KNSCore::EngineBase::signalErrorCode, this, onError);
+    connect(&m_scheduler, &DownloadScheduler::transferFailed, this, onError);
+    connect(&m_scheduler, &DownloadScheduler::finished, this, &KnsInstaller::checkFinished);
+
+    connect(&m_engine, &KNSCore::EngineBase::signalProvidersLoaded, this, [this]() {
+        qWarning() << "providers are loaded";
+        if (!m_providersLoaded) {
+            m_providersLoaded = true;
+            if (m_report) {
+                m_report->endPhase(m_providerLoadPhase, true);
+            }
+            startNextRequest();
+        }
+    });
+}
+
+bool KnsInstaller::init()
+{
+    if (m_report) {
+        m_providerLoadPhase = m_report->startPhase(QStringLiteral("provider-load"), m_knsrcFile);
+    }
+    return m_engine.init(m_knsrcFile);
+}
+
+QString KnsInstaller::knsrcFile() const
+{
+    return m_knsrcFile;
+}
+
+void KnsInstaller::setMaxDownloads(int maxDownloads)
+{
+    m_scheduler.setMaxConcurrent(maxDownloads);
+}
+
+void KnsInstaller::setDownloadCache(DownloadCache *cache)
+{
+    m_scheduler.setDownloadCache(cache);
+}
+
+void KnsInstaller::setReport(InstallReport *report)
+{
+    m_report = report;
+    m_scheduler.setReport(report);
+}
+
+void KnsInstaller::install(const QList<InstallTarget> &targets)
+{
+    if (m_failed) {
+        Q_EMIT finished(KPackageHandler::ExitFailure);
+        return;
+    }
+    m_requests.enqueue(targets);
+    startNextRequest();
+}
+
+bool KnsInstaller::isBusy() const
+{
+    return m_requestRunning || !m_requests.isEmpty();
+}
+
+bool KnsInstaller::hasFailed() const
+{
+    return m_failed;
+}
+
+void KnsInstaller::startNextRequest()
+{
+    if (!m_providersLoaded || m_requestRunning || m_requests.isEmpty()) {
+        return;
+    }
+    m_requestRunning = true;
+    const int serial = ++m_requestSerial;
+    const QList<InstallTarget> targets = m_requests.dequeue();
+    m_searchesRunning = targets.size();
+
+    for (const InstallTarget &target : targets) {
+        KNSCore::SearchRequest request(KNSCore::SortMode::Newest, KNSCore::Filter::ExactEntryId, target.entryId, QStringList{}, 0);
+        KNSCore::ResultsStream *results = m_engine.search(request);
+        auto entryWasFound = std::make_shared<bool>(false);
+        const int searchPhase = m_report ? m_report->startPhase(QStringLiteral("search"), target.entryId) : -1;
+        connect(results, &KNSCore::ResultsStream::entriesFound, this, [this, serial, target, entryWasFound](const KNSCore::Entry::List &list) {
+            if (serial != m_requestSerial) {
+                return;
+            }
+            *entryWasFound = true;
+            entriesLoaded(target, list);
+        });
+        connect(results, &KNSCore::ResultsStream::finished, this, [this, serial, target, entryWasFound, searchPhase]() {
+            if (m_report) {
+                m_report->endPhase(searchPhase, *entryWasFound);
+            }
+            if (serial != m_requestSerial || !m_requestRunning) {
+                return;
+            }
+            if (!*entryWasFound) {
+                qWarning() << "Entry with id" << target.entryId << "could not be found";
+                finishRequest(KPackageHandler::ExitNotFound);
+                return;
+            }
+            m_searchesRunning--;
+            checkFinished();
+        });
+        results->fetch();
+    }
+}
+
+void KnsInstaller::entriesLoaded(const InstallTarget &target, const KNSCore::Entry::List &list)
+{
+    Q_ASSERT(list.size() == 1);
+    const auto entry = list.first();
+    if (target.providerId != entry.providerId()) {
+        qWarning() << "Wrong provider" << target.providerId << "instead of" << entry.providerId();
+        finishRequest(KPackageHandler::ExitNotFound);
+    } else if (entry.status() == KNSCore::Entry::Downloadable) {
+        for (quint8 linkid : target.linkIds) {
+            m_scheduler.enqueue(entry, linkid);
+        }
+    } else {
+        qDebug() << entry.uniqueId() << "already installed.";
+    }
+}
+
+void KnsInstaller::checkFinished()
+{
+    if (m_requestRunning && m_searchesRunning == 0 && m_scheduler.pendingCount() == 0) {
+        finishRequest(KPackageHandler::ExitSuccess);
+    }
+}
+
+void KnsInstaller::finishRequest(int exitCode)
+{
+    if (!m_requestRunning) {
+        return;
+    }
+    m_requestRunning = false;
+    // Makes sure that signals still arriving for this request are ignored
+    ++m_requestSerial;
+    m_scheduler.abort();
+    Q_EMIT finished(exitCode);
+    startNextRequest();
+}
+
+#include "moc_knsinstaller.cpp"
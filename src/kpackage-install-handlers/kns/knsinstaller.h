@@ -0,0 +1,100 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef KNSINSTALLER_H
+#define KNSINSTALLER_H
+
+#include <QList>
+#include <QObject>
+#include <QQueue>
+#include <QUrl>
+
+#include <KNSCore/EngineBase>
+
+#include "downloadscheduler.h"
+
+class DownloadCache;
+class InstallReport;
+
+struct InstallTarget {
+    QString providerId;
+    QString entryId;
+    QList<quint8> linkIds;
+};
+
+/**
+ * Parses a kns://<knsrc>/<providerid>/<entryid>[?linkid=<id>[,<id>...]] link.
+ *
+ * Returns false and prints a warning if the link is malformed.
+ */
+bool parseInstallUrl(const QUrl &url, QString *knsHost, InstallTarget *target);
+
+/**
+ * Returns the full path of the knsrc file called @p knsHost, or an empty string
+ * if no such file is installed.
+ *
+ * Looked up in the persisted KnsrcIndex, which is only rebuilt when knsrc files were added or removed.
+ */
+QString findKnsrcFile(const QString &knsHost);
+
+/**
+ * Installs entries of a single knsrc file.
+ *
+ * The engine is initialized once and kept alive between install() calls, requests
+ * are processed one after the other and each of them is answered with finished().
+ */
+class KnsInstaller : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KnsInstaller(const QString &knsrcFile, QObject *parent = nullptr);
+
+    bool init();
+    QString knsrcFile() const;
+
+    void setMaxDownloads(int maxDownloads);
+    void setDownloadCache(DownloadCache *cache);
+
+    /// Records the provider load, search and install phases into @p report
+    void setReport(InstallReport *report);
+
+    void install(const QList<InstallTarget> &targets);
+    bool isBusy() const;
+
+    /// Whether the providers failed to load, all install() calls fail right away then
+    bool hasFailed() const;
+
+Q_SIGNALS:
+    /// Emitted once per install() call, @p exitCode is one of KPackageHandler::ExitCode
+    void finished(int exitCode);
+
+    /// Emitted when the providers failed to load, after the waiting requests were answered
+    void failed();
+
+private:
+    void startNextRequest();
+    void entriesLoaded(const InstallTarget &target, const KNSCore::Entry::List &list);
+    void checkFinished();
+    void finishRequest(int exitCode);
+
+    const QString m_knsrcFile;
+    KNSCore::EngineBase m_engine;
+    DownloadScheduler m_scheduler;
+    bool m_providersLoaded = false;
+    bool m_failed = false;
+
+    InstallReport *m_report = nullptr;
+    int m_providerLoadPhase = -1;
+
+    QQueue<QList<InstallTarget>> m_requests;
+    bool m_requestRunning = false;
+    // Identifies the running request, so that late signals of a failed one are ignored
+    int m_requestSerial = 0;
+    int m_searchesRunning = 0;
+};
+
+#endif // KNSINSTALLER_H
@@ -0,0 +1,120 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "knsrcindex.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <KNSCore/EngineBase>
+
+/*
+    knsrc-index.json:
+    {
+        "fingerprint": { "<knsrcfiles directory>": <mtime in msecs since epoch> },
+        "files": { "<name>.knsrc": "<path>" }
+    }
+*/
+
+KnsrcIndex::KnsrcIndex()
+{
+    QFile file(fileName());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QJsonObject index = QJsonDocument::fromJson(file.readAll()).object();
+    const QJsonObject fingerprint = index.value(QLatin1String("fingerprint")).toObject();
+    for (auto it = fingerprint.constBegin(); it != fingerprint.constEnd(); ++it) {
+        m_fingerprint.insert(it.key(), it->toInteger());
+    }
+    const QJsonObject files = index.value(QLatin1String("files")).toObject();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        m_files.insert(it.key(), it->toString());
+    }
+}
+
+QString KnsrcIndex::fileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/knshandler/knsrc-index.json");
+}
+
+QHash<QString, qint64> KnsrcIndex::currentFingerprint()
+{
+    QHash<QString, qint64> fingerprint;
+    const QStringList paths = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation, QStringLiteral("knsrcfiles"), QStandardPaths::LocateDirectory);
+    for (const QString &path : paths) {
+        fingerprint.insert(path, QFileInfo(path).lastModified().toMSecsSinceEpoch());
+    }
+    return fingerprint;
+}
+
+QString KnsrcIndex::find(const QString &knsHost)
+{
+    const QHash<QString, qint64> fingerprint = currentFingerprint();
+    bool rebuilt = false;
+    if (fingerprint != m_fingerprint) {
+        m_fingerprint = fingerprint;
+        rebuild();
+        save();
+        rebuilt = true;
+    }
+
+    const QString path = m_files.value(knsHost);
+    // Missing or changed behind the back of the directories, e.g. a legacy knsrc file or a coarse mtime
+    if (!rebuilt && (path.isEmpty() || !QFileInfo::exists(path))) {
+        rebuild();
+        save();
+        return m_files.value(knsHost);
+    }
+    return path;
+}
+
+void KnsrcIndex::rebuild()
+{
+    qDebug() << "rebuilding the knsrc index" << fileName();
+    m_files.clear();
+    const QStringList availableConfigFiles = KNSCore::EngineBase::availableConfigFiles();
+    for (const QString &path : availableConfigFiles) {
+        // The first file of a name shadows the others, as in a lookup of the list
+        const QString name = QFileInfo(path).fileName();
+        if (!m_files.contains(name)) {
+            m_files.insert(name, path);
+        }
+    }
+}
+
+void KnsrcIndex::save() const
+{
+    QJsonObject fingerprint;
+    for (auto it = m_fingerprint.constBegin(); it != m_fingerprint.constEnd(); ++it) {
+        fingerprint.insert(it.key(), it.value());
+    }
+    QJsonObject files;
+    for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+        files.insert(it.key(), it.value());
+    }
+    const QJsonObject index{
+        {QLatin1String("fingerprint"), fingerprint},
+        {QLatin1String("files"), files},
+    };
+
+    QDir().mkpath(QFileInfo(fileName()).path());
+    QSaveFile file(fileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "could not write the knsrc index" << file.fileName() << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+    file.commit();
+}
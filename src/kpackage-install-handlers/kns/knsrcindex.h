@@ -0,0 +1,45 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef KNSRCINDEX_H
+#define KNSRCINDEX_H
+
+#include <QHash>
+#include <QString>
+
+/**
+ * Persisted map from knsrc file names to their full paths.
+ *
+ * Listing all knsrc files through KNSCore::EngineBase::availableConfigFiles()
+ * on every start is comparatively slow. The index remembers the result together
+ * with the modification times of the knsrcfiles directories, checking them costs
+ * a stat per directory. It is rebuilt once one of them changed, i.e. a knsrc file
+ * was added or removed, and when a lookup misses or finds a removed file. The
+ * latter also covers the legacy knsrc files in the config directories, whose
+ * mtime changes with every saved config and is no use as a fingerprint.
+ */
+class KnsrcIndex
+{
+public:
+    KnsrcIndex();
+
+    static QString fileName();
+
+    /// Returns the full path of the knsrc file called @p knsHost, or an empty string if no such file is installed
+    QString find(const QString &knsHost);
+
+private:
+    // knsrcfiles directory -> its modification time in msecs since epoch
+    static QHash<QString, qint64> currentFingerprint();
+    void rebuild();
+    void save() const;
+
+    QHash<QString, qint64> m_fingerprint;
+    QHash<QString, QString> m_files;
+};
+
+#endif // KNSRCINDEX_H
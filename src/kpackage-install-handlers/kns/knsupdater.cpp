@@ -0,0 +1,250 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "knsupdater.h"
+#include "handlerutils.h"
+#include "installreport.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+
+#include <KNSCore/ResultsStream>
+#include <KNSCore/SearchRequest>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+static const int s_pageSize = 100;
+
+KnsUpdater::KnsUpdater(const QString &knsrcFile, QObject *parent)
+    : QObject(parent)
+    , m_knsrcFile(knsrcFile)
+    , m_scheduler(&m_engine)
+{
+    connect(&m_engine, &KNSCore::EngineBase::signalErrorCode, this, [this](KNSCore::ErrorCode::ErrorCode errorCode, const QString &message, const QVariant &metadata) {
+        qWarning() << "kns error:" << errorCode << message << metadata;
+        // Without providers nothing can be checked, later errors only affect single entries
+        if (!m_providersLoaded) {
+            if (m_report) {
+                m_report->endPhase(m_phase, false);
+            }
+            finish(KPackageHandler::ExitFailure);
+        }
+    });
+    connect(&m_engine, &KNSCore::EngineBase::signalProvidersLoaded, this, [this]() {
+        if (m_providersLoaded) {
+            return;
+        }
+        m_providersLoaded = true;
+        if (m_report) {
+            m_report->endPhase(m_phase, true);
+        }
+        listInstalled();
+    });
+
+    connect(&m_scheduler, &DownloadScheduler::transferFinished, this, [this](const KNSCore::Entry &entry) {
+        m_updated << entry.uniqueId();
+    });
+    connect(&m_scheduler, &DownloadScheduler::transferFailed, this, [this](KNSCore::ErrorCode::ErrorCode errorCode, const QString &message) {
+        qWarning() << "update failed:" << errorCode << message;
+        ++m_failed;
+    });
+    connect(&m_scheduler, &DownloadScheduler::finished, this, [this]() {
+        finish(m_failed || !m_skipped.isEmpty() ? KPackageHandler::ExitFailure : KPackageHandler::ExitSuccess);
+    });
+}
+
+bool KnsUpdater::init()
+{
+    if (m_report) {
+        m_phase = m_report->startPhase(QStringLiteral("provider-load"), m_knsrcFile);
+    }
+    return m_engine.init(m_knsrcFile);
+}
+
+void KnsUpdater::setMaxDownloads(int maxDownloads)
+{
+    m_scheduler.setMaxConcurrent(maxDownloads);
+}
+
+void KnsUpdater::setDownloadCache(DownloadCache *cache)
+{
+    m_scheduler.setDownloadCache(cache);
+}
+
+void KnsUpdater::setReport(InstallReport *report)
+{
+    m_report = report;
+    m_scheduler.setReport(report);
+}
+
+void KnsUpdater::setCheckOnly(bool checkOnly)
+{
+    m_checkOnly = checkOnly;
+}
+
+struct SearchState {
+    KNSCore::Entry::List entries;
+    QSet<QString> ids;
+};
+
+// Requests page @p page of @p filter and the following ones until a page brings no new entries, then passes all of them to @p done
+static void searchPages(KNSCore::EngineBase *engine,
+                        KNSCore::Filter filter,
+                        int page,
+                        QObject *context,
+                        const std::shared_ptr<SearchState> &state,
+                        const std::function<void(const KNSCore::Entry::List &)> &done)
+{
+    KNSCore::SearchRequest request(KNSCore::SortMode::Alphabetical, filter, QString(), QStringList{}, page, s_pageSize);
+    KNSCore::ResultsStream *results = engine->search(request);
+    auto newEntries = std::make_shared<int>(0);
+    QObject::connect(results, &KNSCore::ResultsStream::entriesFound, context, [state, newEntries](const KNSCore::Entry::List &list) {
+        for (const KNSCore::Entry &entry : list) {
+            if (!state->ids.contains(entry.uniqueId())) {
+                state->ids.insert(entry.uniqueId());
+                state->entries << entry;
+                ++*newEntries;
+            }
+        }
+    });
+    // Providers which don't page return the same entries again, which ends the search as well
+    QObject::connect(results, &KNSCore::ResultsStream::finished, context, [engine, filter, page, context, state, newEntries, done]() {
+        if (*newEntries == 0) {
+            done(state->entries);
+        } else {
+            searchPages(engine, filter, page + 1, context, state, done);
+        }
+    });
+    results->fetch();
+}
+
+static void searchAll(KNSCore::EngineBase *engine, KNSCore::Filter filter, QObject *context, const std::function<void(const KNSCore::Entry::List &)> &done)
+{
+    searchPages(engine, filter, 0, context, std::make_shared<SearchState>(), done);
+}
+
+// The link the installed version of @p entry came from, or 0 if that can't be told
+static quint8 installedLinkId(const KNSCore::Entry &entry, const KNSCore::Entry &installed)
+{
+    const QList<KNSCore::Entry::DownloadLinkInformation> links = entry.downloadLinkInformationList();
+    // Static providers only have the payload, which is installed as link 1
+    if (links.size() <= 1) {
+        return links.isEmpty() ? 1 : links.constFirst().id;
+    }
+    // Otherwise find the link by the name of the file it installed
+    QSet<QString> installedNames;
+    for (const QString &path : installed.installedFiles()) {
+        installedNames.insert(QFileInfo(path).fileName());
+    }
+    for (const KNSCore::Entry::DownloadLinkInformation &link : links) {
+        if (!link.name.isEmpty() && installedNames.contains(QFileInfo(link.name).fileName())) {
+            return link.id;
+        }
+    }
+    return 0;
+}
+
+void KnsUpdater::listInstalled()
+{
+    if (m_report) {
+        m_phase = m_report->startPhase(QStringLiteral("list-installed"), m_knsrcFile);
+    }
+    searchAll(&m_engine, KNSCore::Filter::Installed, this, [this](const KNSCore::Entry::List &entries) {
+        m_installed = entries;
+        if (m_report) {
+            m_report->endPhase(m_phase, true);
+        }
+        qDebug() << m_installed.size() << "entries installed from" << m_knsrcFile;
+        if (m_installed.isEmpty()) {
+            finish(KPackageHandler::ExitSuccess);
+        } else {
+            checkForUpdates();
+        }
+    });
+}
+
+void KnsUpdater::checkForUpdates()
+{
+    if (m_report) {
+        m_phase = m_report->startPhase(QStringLiteral("update-check"), m_knsrcFile);
+    }
+    // A single search lets every provider check all of its installed entries at once
+    searchAll(&m_engine, KNSCore::Filter::Updates, this, [this](const KNSCore::Entry::List &entries) {
+        for (const KNSCore::Entry &entry : entries) {
+            if (entry.status() == KNSCore::Entry::Updateable) {
+                m_updatable << entry;
+            }
+        }
+        if (m_report) {
+            m_report->endPhase(m_phase, true);
+        }
+        qDebug() << m_updatable.size() << "of" << m_installed.size() << "entries can be updated";
+        installUpdates();
+    });
+}
+
+void KnsUpdater::installUpdates()
+{
+    if (m_checkOnly || m_updatable.isEmpty()) {
+        finish(KPackageHandler::ExitSuccess);
+        return;
+    }
+    int enqueued = 0;
+    for (const KNSCore::Entry &entry : std::as_const(m_updatable)) {
+        auto installed = std::find_if(m_installed.cbegin(), m_installed.cend(), [&entry](const KNSCore::Entry &installedEntry) {
+            return installedEntry.uniqueId() == entry.uniqueId();
+        });
+        const quint8 linkId = installedLinkId(entry, installed != m_installed.cend() ? *installed : entry);
+        if (linkId == 0) {
+            // Installing another link than the one the user picked would replace their choice
+            qWarning() << "skipping" << entry.uniqueId() << ", it has several download links and the installed one is unknown";
+            m_skipped << entry.uniqueId();
+            continue;
+        }
+        m_scheduler.enqueue(entry, linkId);
+        ++enqueued;
+    }
+    if (enqueued == 0) {
+        finish(KPackageHandler::ExitFailure);
+    }
+}
+
+void KnsUpdater::finish(int exitCode)
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_scheduler.abort();
+
+    QTextStream out(stdout);
+    out << m_knsrcFile << ": " << m_installed.size() << " installed, " << m_updatable.size() << " updatable";
+    if (!m_checkOnly) {
+        out << ", " << m_updated.size() << " updated, " << m_skipped.size() << " skipped, "
+            << (m_updatable.size() - m_updated.size() - m_skipped.size()) << " failed";
+    }
+    out << Qt::endl;
+    for (const KNSCore::Entry &entry : std::as_const(m_updatable)) {
+        const char *state = "failed";
+        if (m_checkOnly) {
+            state = "updatable";
+        } else if (m_updated.contains(entry.uniqueId())) {
+            state = "updated";
+        } else if (m_skipped.contains(entry.uniqueId())) {
+            state = "skipped";
+        }
+        out << "  " << state << ' ' << entry.name() << " (" << entry.uniqueId() << ") " << entry.version() << " -> " << entry.updateVersion() << Qt::endl;
+    }
+
+    Q_EMIT finished(exitCode);
+}
+
+#include "moc_knsupdater.cpp"
@@ -0,0 +1,75 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef KNSUPDATER_H
+#define KNSUPDATER_H
+
+#include <QObject>
+
+#include <KNSCore/EngineBase>
+
+#include "downloadscheduler.h"
+
+class DownloadCache;
+class InstallReport;
+
+/**
+ * Updates all entries installed from a single knsrc file.
+ *
+ * Once the providers are loaded, the installed entries are listed and all providers
+ * are asked for updates of them at the same time. The updatable entries are then
+ * installed through a DownloadScheduler, so at most maxDownloads() run in parallel.
+ * Every entry is updated from the download link its installed version came from,
+ * entries for which that can't be told are skipped and reported.
+ * A summary of the changes is printed to stdout before finished() is emitted.
+ */
+class KnsUpdater : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KnsUpdater(const QString &knsrcFile, QObject *parent = nullptr);
+
+    bool init();
+
+    void setMaxDownloads(int maxDownloads);
+    void setDownloadCache(DownloadCache *cache);
+
+    /// Records the provider load, update check and install phases into @p report
+    void setReport(InstallReport *report);
+
+    /// Only lists the available updates instead of installing them
+    void setCheckOnly(bool checkOnly);
+
+Q_SIGNALS:
+    /// @p exitCode is one of KPackageHandler::ExitCode
+    void finished(int exitCode);
+
+private:
+    void listInstalled();
+    void checkForUpdates();
+    void installUpdates();
+    void finish(int exitCode);
+
+    const QString m_knsrcFile;
+    KNSCore::EngineBase m_engine;
+    DownloadScheduler m_scheduler;
+    bool m_providersLoaded = false;
+    bool m_checkOnly = false;
+    bool m_finished = false;
+
+    InstallReport *m_report = nullptr;
+    int m_phase = -1;
+
+    KNSCore::Entry::List m_installed;
+    KNSCore::Entry::List m_updatable;
+    QStringList m_updated;
+    // Entries with several download links whose installed link is unknown
+    QStringList m_skipped;
+    int m_failed = 0;
+};
+
+#endif // KNSUPDATER_H
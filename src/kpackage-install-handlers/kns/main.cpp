@@ -6,26 +6,31 @@
     SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 
+#include <QCommandLineParser>
 #include <QCoreApplication>
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
 #include <QStandardPaths>
-#include <QTimer>
 #include <QUrl>
-#include <QUrlQuery>
 
 #include <KLocalizedString>
 
 #include <KNotification>
 
-#include <KNSCore/EngineBase>
 #include <KNSCore/Question>
 #include <KNSCore/QuestionManager>
-#include <KNSCore/ResultsStream>
-#include <KNSCore/Transaction>
 
+#include "downloadcache.h"
+#include "handlerutils.h"
+#include "installreport.h"
+#include "knshandlerservice.h"
 #include "knshandlerversion.h"
+#include "knsinstaller.h"
+#include "knsrcindex.h"
+#include "knsupdater.h"
+
+#include <memory>
 
 /**
  * Unfortunately there are two knsrc files for the window decorations, but only one is used in the KCM.
@@ -60,57 +65,100 @@ void createSymlinkForWindowDecorations()
 
 int main(int argc, char **argv)
 {
-    createSymlinkForWindowDecorations();
     QCoreApplication app(argc, argv);
     app.setApplicationName(QStringLiteral("kpackage-knshandler"));
     app.setApplicationVersion(knshandlerversion);
     app.setQuitLockEnabled(false);
-    Q_ASSERT(app.arguments().count() == 2);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Installs KNewStuff entries from kns:// links\n\n") + KPackageHandler::exitCodeHelp());
+    parser.addVersionOption();
+    parser.addHelpOption();
+    QCommandLineOption maxDownloadsOption(QStringLiteral("max-downloads"),
+                                          QStringLiteral("Maximum number of payloads to download at the same time"),
+                                          QStringLiteral("count"),
+                                          QStringLiteral("4"));
+    parser.addOption(maxDownloadsOption);
+    QCommandLineOption serviceOption(QStringLiteral("service"), QStringLiteral("Stay resident and accept install requests on a local socket"));
+    parser.addOption(serviceOption);
+    QCommandLineOption idleTimeoutOption(QStringLiteral("idle-timeout"),
+                                         QStringLiteral("Seconds after which an idle service quits"),
+                                         QStringLiteral("seconds"),
+                                         QStringLiteral("300"));
+    parser.addOption(idleTimeoutOption);
+    QCommandLineOption reportOption(QStringLiteral("report"),
+                                    QStringLiteral("Write a JSON report of the install phases to the file, \"-\" for stdout"),
+                                    QStringLiteral("file"));
+    parser.addOption(reportOption);
+    QCommandLineOption downloadCacheOption(QStringLiteral("download-cache"),
+                                           QStringLiteral("Keep downloaded payloads in the directory and reuse them for later installs"),
+                                           QStringLiteral("directory"));
+    parser.addOption(downloadCacheOption);
+    QCommandLineOption downloadCacheSizeOption(QStringLiteral("download-cache-size"),
+                                               QStringLiteral("Maximum size of the download cache in MiB"),
+                                               QStringLiteral("MiB"),
+                                               QStringLiteral("512"));
+    parser.addOption(downloadCacheSizeOption);
+    QCommandLineOption updateOption(QStringLiteral("update"),
+                                    QStringLiteral("Update all entries installed from the knsrc file, e.g. colorschemes.knsrc"),
+                                    QStringLiteral("knsrc"));
+    parser.addOption(updateOption);
+    QCommandLineOption checkUpdatesOption(QStringLiteral("check-updates"), QStringLiteral("With --update, only list the available updates"));
+    parser.addOption(checkUpdatesOption);
+#ifdef TEST
+    QCommandLineOption exitAfterInitOption(QStringLiteral("exit-after-init"),
+                                           QStringLiteral("Quit once the engine is initialized, to measure the startup time"));
+    parser.addOption(exitAfterInitOption);
+#endif
+    parser.addPositionalArgument(QStringLiteral("urls"), QStringLiteral("kns:// links of the entries to install"), QStringLiteral("urls..."));
+    parser.process(app);
+    const bool serviceMode = parser.isSet(serviceOption);
+
+#ifndef TEST
+    // Let an already running service do the work, it has its engines initialized already.
+    // The service only takes the links, runs with options of their own are done here.
+    // That includes the ones set through the environment, the service runs with the environment it was started in.
+    const bool ownOptions = parser.isSet(reportOption) || parser.isSet(maxDownloadsOption) || parser.isSet(downloadCacheOption)
+        || parser.isSet(downloadCacheSizeOption) || qEnvironmentVariableIsSet("KPACKAGE_HANDLER_REPORT")
+        || qEnvironmentVariableIsSet("KNSHANDLER_DOWNLOAD_CACHE");
+    if (!serviceMode && !parser.isSet(updateOption) && !ownOptions) {
+        const int exitCode = KnsHandlerService::forwardToService(parser.positionalArguments());
+        if (exitCode >= 0) {
+            return exitCode;
+        }
+    }
+#endif
 
 #ifdef TEST
     QStandardPaths::setTestModeEnabled(true);
 #endif
 
-    const QUrl url(app.arguments().last());
-    Q_ASSERT(url.isValid());
-    Q_ASSERT(url.scheme() == QLatin1String("kns"));
+    createSymlinkForWindowDecorations();
+    KnsrcIndex knsrcIndex;
 
-    QString knsname;
-    const QStringList availableConfigFiles = KNSCore::EngineBase::availableConfigFiles();
-    auto knsNameIt = std::find_if(availableConfigFiles.begin(), availableConfigFiles.end(), [&url](const QString &availableFile) {
-        return availableFile.endsWith(QLatin1String("/") + url.host());
-    });
+    const int maxDownloads = KPackageHandler::positiveIntValue(parser, maxDownloadsOption);
+    if (maxDownloads < 0) {
+        return KPackageHandler::ExitInvalidArguments;
+    }
 
-    if (knsNameIt == availableConfigFiles.end()) {
-        qWarning() << "couldn't find knsrc file for" << url.host();
-        return 1;
-    } else {
-        knsname = *knsNameIt;
-    }
-
-    const auto pathParts = url.path().split(QLatin1Char('/'), Qt::SkipEmptyParts);
-    if (pathParts.size() != 2) {
-        qWarning() << "wrong format in the url path" << url << pathParts;
-        return 1;
-    }
-    const auto providerid = pathParts.at(0);
-    const auto entryid = pathParts.at(1);
-    int linkid = 1;
-    if (url.hasQuery()) {
-        QUrlQuery query(url);
-        if (query.hasQueryItem(QStringLiteral("linkid"))) {
-            bool ok;
-            linkid = query.queryItemValue(QStringLiteral("linkid")).toInt(&ok);
-            if (!ok) {
-                qWarning() << "linkid is not an integer" << url << pathParts;
-                return 1;
-            }
+    // Opt-in, either on the command line or for all handler runs through the environment
+    std::unique_ptr<DownloadCache> downloadCache;
+    QString downloadCacheDir = parser.value(downloadCacheOption);
+    if (downloadCacheDir.isEmpty()) {
+        downloadCacheDir = qEnvironmentVariable("KNSHANDLER_DOWNLOAD_CACHE");
+    }
+    if (!downloadCacheDir.isEmpty()) {
+        const int downloadCacheSize = KPackageHandler::positiveIntValue(parser, downloadCacheSizeOption);
+        if (downloadCacheSize < 0) {
+            return KPackageHandler::ExitInvalidArguments;
         }
+        if (downloadCacheDir == QLatin1String("default")) {
+            downloadCacheDir = DownloadCache::defaultDirectory();
+        }
+        downloadCache = std::make_unique<DownloadCache>(downloadCacheDir, qint64(downloadCacheSize) * 1024 * 1024);
     }
 
-    KNSCore::EngineBase engine;
-    int installedCount = 0;
-    QObject::connect(KNSCore::QuestionManager::instance(), &KNSCore::QuestionManager::askQuestion, &engine, [](KNSCore::Question *question) {
+    QObject::connect(KNSCore::QuestionManager::instance(), &KNSCore::QuestionManager::askQuestion, &app, [](KNSCore::Question *question) {
         auto discardQuestion = [question]() {
             question->setResponse(KNSCore::Question::InvalidResponse);
         };
@@ -153,57 +201,102 @@ int main(int argc, char **argv)
         }
     });
 
-    const auto onError = [](KNSCore::ErrorCode::ErrorCode errorCode, const QString &message, const QVariant &metadata) {
-        qWarning() << "kns error:" << errorCode << message << metadata;
-        QCoreApplication::exit(1);
-    };
-
-    bool entryWasFound = false;
-    const auto onEntriesLoded = [providerid, linkid, &installedCount, &engine, &entryWasFound, onError](const KNSCore::Entry::List list) {
-        Q_ASSERT(list.size() == 1);
-        entryWasFound = true;
-        const auto entry = list.first();
-        if (providerid != entry.providerId()) {
-            qWarning() << "Wrong provider" << providerid << "instead of" << entry.providerId();
-            QCoreApplication::exit(1);
-        } else if (entry.status() == KNSCore::Entry::Downloadable) {
-            qDebug() << "installing...";
-            installedCount++;
-            auto transaction = KNSCore::Transaction::installLinkId(&engine, entry, linkid);
-            QObject::connect(transaction, &KNSCore::Transaction::signalErrorCode, onError);
-            QObject::connect(transaction, &KNSCore::Transaction::signalEntryEvent, [&installedCount](auto entry, auto event) {
-                if (event == KNSCore::Entry::StatusChangedEvent) {
-                    if (entry.status() == KNSCore::Entry::Installed) {
-                        installedCount--;
-                    }
-                    if (installedCount == 0) {
-                        QCoreApplication::exit(0);
-                    }
-                }
-            });
-        } else if (installedCount == 0) {
-            qDebug() << "already installed.";
-            QCoreApplication::exit(0);
+    if (serviceMode) {
+        const int idleTimeout = KPackageHandler::positiveIntValue(parser, idleTimeoutOption);
+        if (idleTimeout < 0) {
+            return KPackageHandler::ExitInvalidArguments;
         }
-    };
-    QObject::connect(&engine, &KNSCore::EngineBase::signalProvidersLoaded, &engine, [&engine, &entryid, onEntriesLoded, &entryWasFound]() {
-        qWarning() << "providers are loaded";
-        KNSCore::SearchRequest request(KNSCore::SortMode::Newest, KNSCore::Filter::ExactEntryId, entryid, QStringList{}, 0);
-        KNSCore::ResultsStream *results = engine.search(request);
-        QObject::connect(results, &KNSCore::ResultsStream::entriesFound, &engine, onEntriesLoded);
-        QObject::connect(results, &KNSCore::ResultsStream::finished, &engine, [&entryWasFound, &entryid]() {
-            if (!entryWasFound) {
-                qWarning() << "Entry with id" << entryid << "could not be found";
-                QCoreApplication::exit(1);
-            }
-        });
-        results->fetch();
-    });
+        KnsHandlerService service;
+        service.setMaxDownloads(maxDownloads);
+        service.setDownloadCache(downloadCache.get());
+        service.setIdleTimeout(idleTimeout * 1000);
+        if (!service.listen()) {
+            return KPackageHandler::ExitFailure;
+        }
+        return app.exec();
+    }
+
+    InstallReport report(QStringLiteral("knshandler"));
+    if (parser.isSet(reportOption)) {
+        report.setOutputFile(parser.value(reportOption));
+    }
+    report.setUrls(parser.positionalArguments());
+
+    if (parser.isSet(updateOption)) {
+        if (!parser.positionalArguments().isEmpty()) {
+            qWarning() << "--update does not take any urls";
+            return report.finish(KPackageHandler::ExitInvalidArguments);
+        }
+        const QString knsHost = parser.value(updateOption);
+        const int lookupPhase = report.startPhase(QStringLiteral("knsrc-lookup"), knsHost);
+        const QString knsname = knsrcIndex.find(knsHost);
+        report.endPhase(lookupPhase, !knsname.isEmpty());
+        if (knsname.isEmpty()) {
+            qWarning() << "couldn't find knsrc file for" << knsHost;
+            return report.finish(KPackageHandler::ExitNotFound);
+        }
+
+        KnsUpdater updater(knsname);
+        updater.setMaxDownloads(maxDownloads);
+        updater.setDownloadCache(downloadCache.get());
+        updater.setReport(&report);
+        updater.setCheckOnly(parser.isSet(checkUpdatesOption));
+        QObject::connect(&updater, &KnsUpdater::finished, &app, &QCoreApplication::exit);
+        if (!updater.init()) {
+            qWarning() << "couldn't initialize" << knsname;
+            return report.finish(KPackageHandler::ExitFailure);
+        }
+        return report.finish(app.exec());
+    }
 
-    QObject::connect(&engine, &KNSCore::EngineBase::signalErrorCode, &engine, onError);
-    if (!engine.init(knsname)) {
+    QList<QUrl> urls;
+    if (!KPackageHandler::parseUrls(parser, QStringLiteral("kns"), &urls)) {
+        return report.finish(KPackageHandler::ExitInvalidArguments);
+    }
+
+    QString knsHost;
+    QList<InstallTarget> targets;
+    for (const QUrl &url : std::as_const(urls)) {
+        QString urlHost;
+        InstallTarget target;
+        if (!parseInstallUrl(url, &urlHost, &target)) {
+            return report.finish(KPackageHandler::ExitInvalidArguments);
+        }
+        // All entries are installed through the same engine, so they have to share their knsrc file
+        if (!knsHost.isEmpty() && knsHost != urlHost) {
+            qWarning() << "all urls need to use the same knsrc file" << knsHost << urlHost;
+            return report.finish(KPackageHandler::ExitInvalidArguments);
+        }
+        knsHost = urlHost;
+        targets << target;
+    }
+
+    const int lookupPhase = report.startPhase(QStringLiteral("knsrc-lookup"), knsHost);
+    const QString knsname = knsrcIndex.find(knsHost);
+    report.endPhase(lookupPhase, !knsname.isEmpty());
+    if (knsname.isEmpty()) {
+        qWarning() << "couldn't find knsrc file for" << knsHost;
+        return report.finish(KPackageHandler::ExitNotFound);
+    }
+
+    KnsInstaller installer(knsname);
+    installer.setMaxDownloads(maxDownloads);
+    installer.setDownloadCache(downloadCache.get());
+    installer.setReport(&report);
+    QObject::connect(&installer, &KnsInstaller::finished, &app, &QCoreApplication::exit);
+    installer.install(targets);
+    if (!installer.init()) {
         qWarning() << "couldn't initialize" << knsname;
-        return 1;
+        return report.finish(KPackageHandler::ExitFailure);
+    }
+#ifdef TEST
+    if (parser.isSet(exitAfterInitOption)) {
+        return report.finish(KPackageHandler::ExitSuccess);
+    }
+#endif
+    const int exitCode = app.exec();
+    if (downloadCache) {
+        qDebug() << "download cache" << downloadCache->directory() << downloadCache->hits() << "hits," << downloadCache->misses() << "misses";
     }
-    return app.exec();
+    return report.finish(exitCode);
 }
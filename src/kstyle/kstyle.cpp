@@ -27,40 +27,702 @@
 */
 
 #include "kstyle.h"
+#include "kstyle_debug.h"
 
 #include <QAbstractItemView>
 #include <QApplication>
+#include <QCache>
 #include <QDialogButtonBox>
+#include <QElapsedTimer>
 #include <QEvent>
+#include <QFile>
 #include <QIcon>
+#include <QIconEngine>
+#include <QPainter>
+#include <QPointer>
 #include <QPushButton>
+#include <QScreen>
+#include <QSet>
 #include <QShortcut>
+#include <QSocketNotifier>
 #include <QStyleOption>
+#include <QTimer>
 #include <QToolBar>
 
 #include <KColorScheme>
 #include <KConfigGroup>
 #include <KIconLoader>
 #include <KMessageWidget>
+#include <KSharedConfig>
+
+#include <optional>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 // ----------------------------------------------------------------------------
 
 static const QStyle::StyleHint SH_KCustomStyleElement = (QStyle::StyleHint)0xff000001;
 static const int X_KdeBase = 0xff000000;
 
+/*
+    The kdeglobals settings styleHint() depends on. A single hint reads only its own entry,
+    queryStyle() reads all of them once and answers every hint of the query from the snapshot.
+*/
+struct KStyleSettings {
+    static KStyleSettings read();
+
+    static bool readShowIconsOnPushButtons(const KSharedConfigPtr &config);
+    static bool readGraphicEffects(const KSharedConfigPtr &config);
+    static int readToolButtonStyle(const KSharedConfigPtr &config, bool otherToolbars);
+    static bool readLeftClickAbsolutePosition(const KSharedConfigPtr &config);
+
+    bool showIconsOnPushButtons = true;
+    bool graphicEffects = true;
+    int toolButtonStyle = Qt::ToolButtonTextBesideIcon;
+    int toolButtonStyleOtherToolbars = Qt::ToolButtonIconOnly;
+    bool leftClickAbsolutePosition = true;
+};
+
+KStyleSettings KStyleSettings::read()
+{
+    const KSharedConfigPtr config = KSharedConfig::openConfig();
+    KStyleSettings settings;
+    settings.showIconsOnPushButtons = readShowIconsOnPushButtons(config);
+    settings.graphicEffects = readGraphicEffects(config);
+    settings.toolButtonStyle = readToolButtonStyle(config, false);
+    settings.toolButtonStyleOtherToolbars = readToolButtonStyle(config, true);
+    settings.leftClickAbsolutePosition = readLeftClickAbsolutePosition(config);
+    return settings;
+}
+
+bool KStyleSettings::readShowIconsOnPushButtons(const KSharedConfigPtr &config)
+{
+    KConfigGroup g(config, QStringLiteral("KDE"));
+    return g.readEntry("ShowIconsOnPushButtons", true);
+}
+
+bool KStyleSettings::readGraphicEffects(const KSharedConfigPtr &config)
+{
+    KConfigGroup g(config, QStringLiteral("KDE-Global GUI Settings"));
+    return g.readEntry("GraphicEffectsLevel", true);
+}
+
+int KStyleSettings::readToolButtonStyle(const KSharedConfigPtr &config, bool otherToolbars)
+{
+    KConfigGroup g(config, QStringLiteral("Toolbar style"));
+
+    QString buttonStyle;
+    if (otherToolbars) {
+        buttonStyle = g.readEntry("ToolButtonStyleOtherToolbars", "NoText").toLower();
+    } else {
+        buttonStyle = g.readEntry("ToolButtonStyle", "TextBesideIcon").toLower();
+    }
+
+    return buttonStyle == QLatin1String("textbesideicon") ? Qt::ToolButtonTextBesideIcon
+        : buttonStyle == QLatin1String("icontextright")   ? Qt::ToolButtonTextBesideIcon
+        : buttonStyle == QLatin1String("textundericon")   ? Qt::ToolButtonTextUnderIcon
+        : buttonStyle == QLatin1String("icontextbottom")  ? Qt::ToolButtonTextUnderIcon
+        : buttonStyle == QLatin1String("textonly")        ? Qt::ToolButtonTextOnly
+                                                          : Qt::ToolButtonIconOnly;
+}
+
+bool KStyleSettings::readLeftClickAbsolutePosition(const KSharedConfigPtr &config)
+{
+    KConfigGroup g(config, QStringLiteral("KDE"));
+    return !g.readEntry("ScrollbarLeftClickNavigatesByPage", false);
+}
+
+/*
+    Identifies a tile of cachedTile(). The palette is compared by its cache key, which changes
+    with every modification of the palette.
+*/
+struct KStyleTileKey {
+    QString element;
+    int state;
+    int direction;
+    qint64 palette;
+    QSize size;
+    qreal devicePixelRatio;
+
+    bool operator==(const KStyleTileKey &other) const
+    {
+        return element == other.element && state == other.state && direction == other.direction && palette == other.palette && size == other.size
+            && devicePixelRatio == other.devicePixelRatio;
+    }
+};
+
+static size_t qHash(const KStyleTileKey &key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.element, key.state, key.direction, key.palette, key.size.width(), key.size.height(), key.devicePixelRatio);
+}
+
+/*
+    Measures how long the windows take to paint a frame, i.e. to process the update request
+    which makes a window sync and paint its dirty widgets.
+
+    The update request itself is left alone. Seeing it starts the measurement, which ends when
+    an event posted to the timer at that moment arrives, right after the request was processed.
+*/
+class KStyleFrameTimer : public QObject
+{
+public:
+    explicit KStyleFrameTimer(KStyle *style);
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+protected:
+    void customEvent(QEvent *event) override;
+
+private:
+    static QEvent::Type frameDoneEvent();
+
+    KStyle *const m_style;
+    // Runs while a frame is being measured
+    QElapsedTimer m_frameTimer;
+};
+
+/*
+    Trims the style's caches when the system runs low on memory.
+
+    The kernel notifies about memory pressure through a PSI trigger registered on
+    /proc/pressure/memory. If the kernel doesn't allow to register one, the monitor stays
+    inactive. Only files given through KSTYLE_PSI_FILE, e.g. by tests, are polled for their
+    "some avg10" value instead.
+*/
+class KStyleMemoryPressureMonitor : public QObject
+{
+public:
+    KStyleMemoryPressureMonitor(KStyle *style, int threshold, int pollInterval);
+    ~KStyleMemoryPressureMonitor() override;
+
+    bool isActive() const;
+
+private:
+    bool registerTrigger();
+    void poll();
+    void pressureReported();
+
+    KStyle *const m_style;
+    const QString m_fileName;
+    const int m_threshold;
+    int m_fd = -1;
+    QTimer m_pollTimer;
+    QElapsedTimer m_lastTrim;
+};
+
+/*
+    Keeps hovering over an item view cheap: hover moves are delivered to the view at most once
+    per frame, only the latest position of a frame counts. Entering and leaving the viewport
+    is passed on as is. The view itself already limits the updates of a hover move to the
+    rows involved.
+*/
+class KStyleHoverThrottle : public QObject
+{
+public:
+    explicit KStyleHoverThrottle(QWidget *viewport);
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    int interval() const;
+    void deliver(const QPointF &position);
+
+    QWidget *const m_viewport;
+    QTimer m_timer;
+    QPointF m_lastPosition = QPointF(-1, -1);
+    QPointF m_pendingPosition;
+    bool m_pending = false;
+    bool m_delivering = false;
+};
+
+/*
+    The precomposed icons with an emblem, e.g. the link icons of standardIcon(). Composing the
+    emblem for every paint would be expensive in file views showing lots of links, so every
+    combination of icon theme, size, scale, mode and state is composed once and kept in an LRU.
+*/
+class KStyleIconCache : public QObject
+{
+public:
+    explicit KStyleIconCache(QObject *parent);
+
+    QIcon emblemIcon(const QString &iconName, const QString &emblemName);
+    QPixmap emblemPixmap(const QString &iconName, const QString &emblemName, const QSize &size, qreal scale, QIcon::Mode mode, QIcon::State state);
+
+    QCache<QString, QPixmap> pixmaps;
+
+private:
+    QHash<QString, QIcon> m_icons;
+};
+
+/*
+    Icons handed out by KStyleIconCache, they stay usable if the style goes away but are no
+    longer cached then.
+*/
+class KStyleEmblemIconEngine : public QIconEngine
+{
+public:
+    KStyleEmblemIconEngine(const QString &iconName, const QString &emblemName, KStyleIconCache *cache)
+        : m_iconName(iconName)
+        , m_emblemName(emblemName)
+        , m_cache(cache)
+    {
+    }
+
+    void paint(QPainter *painter, const QRect &rect, QIcon::Mode mode, QIcon::State state) override
+    {
+        const qreal scale = painter->device() ? painter->device()->devicePixelRatio() : qApp->devicePixelRatio();
+        painter->drawPixmap(rect, scaledPixmap(rect.size(), mode, state, scale));
+    }
+
+    QPixmap pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state) override
+    {
+        return scaledPixmap(size, mode, state, 1.0);
+    }
+
+    QPixmap scaledPixmap(const QSize &size, QIcon::Mode mode, QIcon::State state, qreal scale) override
+    {
+        if (m_cache) {
+            return m_cache->emblemPixmap(m_iconName, m_emblemName, size, scale, mode, state);
+        }
+        KStyleIconCache uncached(nullptr);
+        return uncached.emblemPixmap(m_iconName, m_emblemName, size, scale, mode, state);
+    }
+
+    QList<QSize> availableSizes(QIcon::Mode mode, QIcon::State state) override
+    {
+        return QIcon::fromTheme(m_iconName).availableSizes(mode, state);
+    }
+
+    QIconEngine *clone() const override
+    {
+        return new KStyleEmblemIconEngine(m_iconName, m_emblemName, m_cache);
+    }
+
+    QString key() const override
+    {
+        return QStringLiteral("KStyleEmblemIconEngine");
+    }
+
+    QString iconName() override
+    {
+        return m_iconName;
+    }
+
+private:
+    const QString m_iconName;
+    const QString m_emblemName;
+    QPointer<KStyleIconCache> m_cache;
+};
+
+class KStylePrivate;
+
+/*
+    With DeferredPolish, widgets polished while they are hidden in an already shown window,
+    e.g. on the pages of a tab or stacked widget, only get the expensive part of
+    KStyle::polish() once they are shown first. Widgets of windows which aren't shown yet
+    are polished right away, they are shown together with their window.
+*/
+class KStyleDeferredPolish : public QObject
+{
+public:
+    KStyleDeferredPolish(KStylePrivate *d, QObject *parent);
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    KStylePrivate *const d;
+};
+
 class KStylePrivate
 {
 public:
     KStylePrivate();
 
+    void loadFrameBudgetSettings();
+    // Returns true if the quality changed
+    bool addFrameTime(qint64 microseconds);
+    // The part of KStyle::polish() which creates objects or reads the color scheme
+    void polishExpensive(QWidget *widget);
+
     QHash<QString, int> styleElements;
-    int hintCounter, controlCounter, subElementCounter;
+    // The values of styleElements
+    QSet<int> usedElementIds;
+
+    // Adaptive animations
+    bool adaptiveAnimations = false;
+    qint64 frameBudget = 0; // usecs
+    int reduceThreshold = 100;
+    int disableThreshold = 200;
+    int recoverThreshold = 50;
+    int frameWindow = 30;
+    QList<qint64> frameTimes;
+    KStyle::AnimationQuality animationQuality = KStyle::FullAnimations;
+    KStyleFrameTimer *frameTimer = nullptr;
+
+    QList<std::function<qint64()>> cacheTrimmers;
+    KStyleMemoryPressureMonitor *memoryPressureMonitor = nullptr;
+
+    QList<std::function<KStyle::MemoryUsage()>> memoryUsageReporters;
+    QTimer *memoryDumpTimer = nullptr;
+
+    // LRU of the tiles of cachedTile(), the cost of a tile is its size in bytes
+    QCache<KStyleTileKey, QPixmap> tileCache;
+    qint64 tileHits = 0;
+    qint64 tileMisses = 0;
+
+    KStyleIconCache *iconCache = nullptr;
+
+    // Set while queryStyle() runs
+    const KStyleSettings *querySettings = nullptr;
+
+    bool coalescedItemViewHover = false;
+    KStyleDeferredPolish *deferredPolish = nullptr;
 };
 
-KStylePrivate::KStylePrivate()
+KStylePrivate::KStylePrivate() = default;
+
+KStyleDeferredPolish::KStyleDeferredPolish(KStylePrivate *d, QObject *parent)
+    : QObject(parent)
+    , d(d)
+{
+}
+
+bool KStyleDeferredPolish::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Show) {
+        watched->removeEventFilter(this);
+        d->polishExpensive(static_cast<QWidget *>(watched));
+    }
+    return false;
+}
+
+KStyleIconCache::KStyleIconCache(QObject *parent)
+    : QObject(parent)
+    , pixmaps(4 * 1024 * 1024)
+{
+}
+
+QIcon KStyleIconCache::emblemIcon(const QString &iconName, const QString &emblemName)
+{
+    // Always the same QIcon, so that views and QIcon's own caching see a single icon
+    const QString key = iconName + QLatin1Char('+') + emblemName;
+    auto it = m_icons.constFind(key);
+    if (it == m_icons.constEnd()) {
+        it = m_icons.insert(key, QIcon(new KStyleEmblemIconEngine(iconName, emblemName, this)));
+    }
+    return *it;
+}
+
+QPixmap KStyleIconCache::emblemPixmap(const QString &iconName,
+                                      const QString &emblemName,
+                                      const QSize &size,
+                                      qreal scale,
+                                      QIcon::Mode mode,
+                                      QIcon::State state)
+{
+    if (size.isEmpty()) {
+        return QPixmap();
+    }
+
+    // The theme is part of the key, icons composed for the previous theme simply age out
+    const QString key = QStringLiteral("%1+%2@%3/%4x%5@%6/%7/%8")
+                            .arg(iconName, emblemName, QIcon::themeName())
+                            .arg(size.width())
+                            .arg(size.height())
+                            .arg(scale)
+                            .arg(int(mode))
+                            .arg(int(state));
+    if (const QPixmap *pixmap = pixmaps.object(key)) {
+        return *pixmap;
+    }
+
+    QPixmap pixmap = QIcon::fromTheme(iconName).pixmap(size, scale, mode, state);
+    if (pixmap.isNull()) {
+        return pixmap;
+    }
+    // Same placement as the first overlay of KIconLoader: the bottom right quarter
+    const QSize iconSize = pixmap.deviceIndependentSize().toSize();
+    const QSize emblemSize = iconSize / 2;
+    const QPixmap emblem = QIcon::fromTheme(emblemName).pixmap(emblemSize, scale, mode, state);
+    if (!emblem.isNull()) {
+        QPainter painter(&pixmap);
+        painter.drawPixmap(QRect(QPoint(iconSize.width() - emblemSize.width(), iconSize.height() - emblemSize.height()), emblemSize), emblem);
+    }
+
+    pixmaps.insert(key, new QPixmap(pixmap), qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8);
+    return pixmap;
+}
+
+void KStylePrivate::polishExpensive(QWidget *w)
+{
+    if (QAbstractItemView *itemView = qobject_cast<QAbstractItemView *>(w)) {
+        QWidget *viewport = itemView->viewport();
+        if (coalescedItemViewHover && !viewport->findChild<QObject *>(QStringLiteral("KStyleHoverThrottle"), Qt::FindDirectChildrenOnly)) {
+            new KStyleHoverThrottle(viewport);
+        }
+    }
+
+    if (QDialogButtonBox *box = qobject_cast<QDialogButtonBox *>(w)) {
+        QPushButton *button = box->button(QDialogButtonBox::Ok);
+
+        if (button) {
+            auto shortcut = new QShortcut(Qt::CTRL | Qt::Key_Return, button);
+            QObject::connect(shortcut, &QShortcut::activated, button, &QPushButton::click);
+        }
+    }
+    if (auto messageWidget = qobject_cast<KMessageWidget *>(w)) {
+        KColorScheme scheme;
+        QColor color;
+        QPalette palette = messageWidget->palette();
+        switch (messageWidget->messageType()) {
+        case KMessageWidget::Positive:
+            color = scheme.foreground(KColorScheme::PositiveText).color();
+            break;
+        case KMessageWidget::Information:
+            color = scheme.foreground(KColorScheme::ActiveText).color();
+            break;
+        case KMessageWidget::Warning:
+            color = scheme.foreground(KColorScheme::NeutralText).color();
+            break;
+        case KMessageWidget::Error:
+            color = scheme.foreground(KColorScheme::NegativeText).color();
+            break;
+        }
+        palette.setColor(QPalette::Window, color);
+        messageWidget->setPalette(palette);
+    }
+}
+
+void KStylePrivate::loadFrameBudgetSettings()
+{
+    KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE-Global GUI Settings"));
+    adaptiveAnimations = g.readEntry("AdaptiveAnimations", false);
+
+    const qreal budgetMs = g.readEntry("AnimationFrameBudget", 0.0);
+    if (budgetMs > 0) {
+        frameBudget = qMax<qint64>(1, qRound64(budgetMs * 1000));
+    } else {
+        const QScreen *screen = QGuiApplication::primaryScreen();
+        const qreal refreshRate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60;
+        frameBudget = qMax<qint64>(1, qRound64(1000000 / refreshRate));
+    }
+    reduceThreshold = qMax(1, g.readEntry("AnimationReduceThreshold", 100));
+    disableThreshold = qMax(reduceThreshold, g.readEntry("AnimationDisableThreshold", 200));
+    recoverThreshold = qBound(1, g.readEntry("AnimationRecoverThreshold", 50), reduceThreshold);
+    frameWindow = qMax(1, g.readEntry("AnimationFrameWindow", 30));
+}
+
+bool KStylePrivate::addFrameTime(qint64 microseconds)
+{
+    frameTimes << microseconds;
+    if (frameTimes.size() < frameWindow) {
+        return false;
+    }
+    while (frameTimes.size() > frameWindow) {
+        frameTimes.removeFirst();
+    }
+
+    qint64 total = 0;
+    for (qint64 frameTime : std::as_const(frameTimes)) {
+        total += frameTime;
+    }
+    const qint64 percentOfBudget = total * 100 / (frameWindow * frameBudget);
+
+    // The thresholds are apart, so that the quality doesn't flip back and forth around a single one
+    KStyle::AnimationQuality quality = animationQuality;
+    if (percentOfBudget > disableThreshold) {
+        quality = KStyle::NoAnimations;
+    } else if (percentOfBudget > reduceThreshold) {
+        quality = qMax(quality, KStyle::ReducedAnimations);
+    } else if (percentOfBudget < recoverThreshold && quality != KStyle::FullAnimations) {
+        quality = static_cast<KStyle::AnimationQuality>(quality - 1);
+    }
+    if (quality == animationQuality) {
+        return false;
+    }
+
+    animationQuality = quality;
+    // Judge the new quality by its own frames only
+    frameTimes.clear();
+    return true;
+}
+
+KStyleFrameTimer::KStyleFrameTimer(KStyle *style)
+    : QObject(style)
+    , m_style(style)
+{
+}
+
+bool KStyleFrameTimer::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::UpdateRequest && !m_frameTimer.isValid()) {
+        m_frameTimer.start();
+        // Queued in front of everything but other high priority events, so it arrives as soon as the request is done
+        QCoreApplication::postEvent(this, new QEvent(frameDoneEvent()), Qt::HighEventPriority);
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void KStyleFrameTimer::customEvent(QEvent *event)
+{
+    if (event->type() != frameDoneEvent()) {
+        QObject::customEvent(event);
+        return;
+    }
+    const qint64 microseconds = m_frameTimer.nsecsElapsed() / 1000;
+    m_frameTimer.invalidate();
+    m_style->reportFrameTime(microseconds);
+}
+
+QEvent::Type KStyleFrameTimer::frameDoneEvent()
+{
+    static const auto type = static_cast<QEvent::Type>(QEvent::registerEventType());
+    return type;
+}
+
+KStyleMemoryPressureMonitor::KStyleMemoryPressureMonitor(KStyle *style, int threshold, int pollInterval)
+    : QObject(style)
+    , m_style(style)
+    , m_fileName(qEnvironmentVariable("KSTYLE_PSI_FILE", QStringLiteral("/proc/pressure/memory")))
+    , m_threshold(threshold)
+{
+    if (qEnvironmentVariableIsSet("KSTYLE_PSI_FILE")) {
+        connect(&m_pollTimer, &QTimer::timeout, this, &KStyleMemoryPressureMonitor::poll);
+        m_pollTimer.start(pollInterval);
+    } else if (!registerTrigger()) {
+        qCDebug(KSTYLE) << "could not register a memory pressure trigger on" << m_fileName << ", not trimming caches on memory pressure";
+    }
+}
+
+bool KStyleMemoryPressureMonitor::isActive() const
+{
+    return m_fd >= 0 || m_pollTimer.isActive();
+}
+
+KStyleMemoryPressureMonitor::~KStyleMemoryPressureMonitor()
+{
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+}
+
+bool KStyleMemoryPressureMonitor::registerTrigger()
+{
+#ifdef Q_OS_LINUX
+    m_fd = ::open(QFile::encodeName(m_fileName).constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        return false;
+    }
+    // Stall time within a 2s window, unprivileged triggers need windows of a multiple of 2s
+    const QByteArray trigger = "some " + QByteArray::number(m_threshold * 20000) + " 2000000";
+    if (::write(m_fd, trigger.constData(), trigger.size() + 1) < 0) {
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    // The kernel signals the trigger as POLLPRI, which QSocketNotifier reports as exception
+    auto notifier = new QSocketNotifier(m_fd, QSocketNotifier::Exception, this);
+    connect(notifier, &QSocketNotifier::activated, this, &KStyleMemoryPressureMonitor::pressureReported);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void KStyleMemoryPressureMonitor::poll()
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    const QList<QByteArray> fields = file.readLine().simplified().split(' ');
+    if (fields.value(0) != "some" || !fields.value(1).startsWith("avg10=")) {
+        return;
+    }
+    if (fields.at(1).mid(6).toDouble() >= m_threshold) {
+        pressureReported();
+    }
+}
+
+void KStyleMemoryPressureMonitor::pressureReported()
+{
+    // The pressure is reported as long as it lasts, the caches are refilled slowly though
+    if (m_lastTrim.isValid() && m_lastTrim.elapsed() < 10000) {
+        return;
+    }
+    m_lastTrim.start();
+    m_style->trimCaches();
+}
+
+KStyleHoverThrottle::KStyleHoverThrottle(QWidget *viewport)
+    : QObject(viewport)
+    , m_viewport(viewport)
 {
-    controlCounter = subElementCounter = X_KdeBase;
-    hintCounter = X_KdeBase + 1; // sic! X_KdeBase is covered by SH_KCustomStyleElement
+    setObjectName(QStringLiteral("KStyleHoverThrottle"));
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, [this]() {
+        if (m_pending) {
+            m_pending = false;
+            deliver(m_pendingPosition);
+            m_timer.start(interval());
+        }
+    });
+    viewport->installEventFilter(this);
+}
+
+bool KStyleHoverThrottle::eventFilter(QObject *watched, QEvent *event)
+{
+    if (m_delivering || watched != m_viewport) {
+        return false;
+    }
+
+    switch (event->type()) {
+    case QEvent::HoverEnter:
+        m_lastPosition = static_cast<QHoverEvent *>(event)->position();
+        return false;
+    case QEvent::HoverMove: {
+        const QPointF position = static_cast<QHoverEvent *>(event)->position();
+        if (m_timer.isActive()) {
+            // Only the latest position of this frame matters
+            m_pendingPosition = position;
+            m_pending = true;
+        } else {
+            deliver(position);
+            m_timer.start(interval());
+        }
+        return true;
+    }
+    case QEvent::HoverLeave:
+        // A move still pending would hover an index again after leaving
+        m_timer.stop();
+        m_pending = false;
+        m_lastPosition = QPointF(-1, -1);
+        return false;
+    default:
+        return false;
+    }
+}
+
+int KStyleHoverThrottle::interval() const
+{
+    const QScreen *screen = m_viewport->screen();
+    const qreal refreshRate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60;
+    return qMax(1, qRound(1000 / refreshRate));
+}
+
+void KStyleHoverThrottle::deliver(const QPointF &position)
+{
+    QHoverEvent event(QEvent::HoverMove, position, m_viewport->mapToGlobal(position), m_lastPosition);
+    m_delivering = true;
+    QCoreApplication::sendEvent(m_viewport, &event);
+    m_delivering = false;
+    m_lastPosition = position;
 }
 
 /*
@@ -99,6 +761,50 @@ QStyle::SubElement KStyle::customSubElement(const QString &element, const QWidge
 KStyle::KStyle()
     : d(new KStylePrivate)
 {
+    d->loadFrameBudgetSettings();
+    if (d->adaptiveAnimations) {
+        d->frameTimer = new KStyleFrameTimer(this);
+    }
+
+    if (KSTYLE().isDebugEnabled()) {
+        d->memoryDumpTimer = new QTimer(this);
+        connect(d->memoryDumpTimer, &QTimer::timeout, this, &KStyle::dumpMemoryUsage);
+        const int interval = qEnvironmentVariableIsSet("KSTYLE_MEMORY_DUMP_INTERVAL") ? qEnvironmentVariableIntValue("KSTYLE_MEMORY_DUMP_INTERVAL") : 60;
+        d->memoryDumpTimer->start(std::chrono::seconds(qMax(1, interval)));
+    }
+
+    KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE-Global GUI Settings"));
+    d->coalescedItemViewHover = g.readEntry("CoalescedItemViewHover", false);
+    if (g.readEntry("DeferredPolish", false)) {
+        d->deferredPolish = new KStyleDeferredPolish(d, this);
+    }
+    setTileCacheLimit(qMax(0, g.readEntry("TileCacheSize", 8192)) * qint64(1024));
+    addCacheTrimmer([this]() {
+        const qint64 bytes = d->tileCache.totalCost();
+        d->tileCache.clear();
+        return bytes;
+    });
+    addMemoryUsageReporter([this]() {
+        return MemoryUsage{QStringLiteral("tileCache"), d->tileCache.size(), qint64(d->tileCache.totalCost())};
+    });
+    d->iconCache = new KStyleIconCache(this);
+    addCacheTrimmer([this]() {
+        const qint64 bytes = d->iconCache->pixmaps.totalCost();
+        d->iconCache->pixmaps.clear();
+        return bytes;
+    });
+    addMemoryUsageReporter([this]() {
+        return MemoryUsage{QStringLiteral("iconCache"), d->iconCache->pixmaps.size(), qint64(d->iconCache->pixmaps.totalCost())};
+    });
+    if (g.readEntry("TrimCachesOnMemoryPressure", false)) {
+        d->memoryPressureMonitor = new KStyleMemoryPressureMonitor(this,
+                                                                   qBound(1, g.readEntry("MemoryPressureThreshold", 10), 100),
+                                                                   qMax(10, g.readEntry("MemoryPressurePollInterval", 2000)));
+        if (!d->memoryPressureMonitor->isActive()) {
+            delete d->memoryPressureMonitor;
+            d->memoryPressureMonitor = nullptr;
+        }
+    }
 }
 
 KStyle::~KStyle()
@@ -144,77 +850,165 @@ KStyle::~KStyle()
 /*
     The functions called by the real style implementation to add support for a certain element.
     Checks for well-formed string (containing the element prefix) and returns 0 otherwise.
-    Checks whether the element is already supported or inserts it otherwise; Returns the proper id
+    Checks whether the element is already supported or inserts it otherwise; Returns the proper id,
+    which only depends on the element string and thus survives style reloads, unless it collides
+    with the id of another element
     NOTICE: We could check for "X-KDE-CustomElements", but this would bloat style start up times
     (if they e.g. register 100 elements or so)
 */
 
-static inline int newStyleElement(const QString &element, const char *check, int &counter, QHash<QString, int> *elements)
+static inline int newStyleElement(const QString &element, const char *check, QHash<QString, int> *elements, QSet<int> *usedIds)
 {
     if (!element.contains(QLatin1String(check))) {
         return 0;
     }
     int id = elements->value(element, 0);
-    if (!id) {
-        ++counter;
-        id = counter;
-        elements->insert(element, id);
+    if (id) {
+        return id;
+    }
+
+    // The id is derived from the name alone (FNV-1a, independent of Qt's per process hash seed),
+    // so every instance of a style hands out the same ids and widgets can keep the ones they cached
+    quint32 hash = 2166136261u;
+    for (const QChar c : element) {
+        hash = (hash ^ c.unicode()) * 16777619u;
     }
+    // The low 24 bits above X_KdeBase, X_KdeBase itself and SH_KCustomStyleElement are reserved
+    quint32 offset = qMax(hash & 0xffffffu, 2u);
+
+    // Colliding names (rare in 2^24 ids) still need distinct ids, the next free one depends on the
+    // registration order though, so the id is not stable anymore
+    if (usedIds->contains(int(quint32(X_KdeBase) | offset))) {
+        qCWarning(KSTYLE) << "the id of the style element" << element << "collides with another element, its id depends on the registration order";
+        do {
+            offset = offset == 0xffffffu ? 2u : offset + 1;
+        } while (usedIds->contains(int(quint32(X_KdeBase) | offset)));
+    }
+
+    id = int(quint32(X_KdeBase) | offset);
+    elements->insert(element, id);
+    usedIds->insert(id);
     return id;
 }
 
 QStyle::StyleHint KStyle::newStyleHint(const QString &element)
 {
-    return (StyleHint)newStyleElement(element, "SH_", d->hintCounter, &d->styleElements);
+    return (StyleHint)newStyleElement(element, "SH_", &d->styleElements, &d->usedElementIds);
 }
 
 QStyle::ControlElement KStyle::newControlElement(const QString &element)
 {
-    return (ControlElement)newStyleElement(element, "CE_", d->controlCounter, &d->styleElements);
+    return (ControlElement)newStyleElement(element, "CE_", &d->styleElements, &d->usedElementIds);
 }
 
 KStyle::SubElement KStyle::newSubElement(const QString &element)
 {
-    return (SubElement)newStyleElement(element, "SE_", d->subElementCounter, &d->styleElements);
+    return (SubElement)newStyleElement(element, "SE_", &d->styleElements, &d->usedElementIds);
+}
+
+KStyle::AnimationQuality KStyle::animationQuality() const
+{
+    return d->animationQuality;
+}
+
+void KStyle::reportFrameTime(qint64 microseconds)
+{
+    if (d->adaptiveAnimations && d->addFrameTime(microseconds)) {
+        Q_EMIT animationQualityChanged(d->animationQuality);
+    }
+}
+
+qint64 KStyle::trimCaches()
+{
+    qint64 bytes = 0;
+    for (const auto &trimmer : std::as_const(d->cacheTrimmers)) {
+        bytes += trimmer();
+    }
+    Q_EMIT cachesTrimmed(bytes);
+    qCDebug(KSTYLE) << "trimmed caches, released" << bytes << "bytes";
+    if (d->memoryDumpTimer) {
+        dumpMemoryUsage();
+    }
+    return bytes;
+}
+
+void KStyle::addCacheTrimmer(const std::function<qint64()> &trimmer)
+{
+    d->cacheTrimmers << trimmer;
+}
+
+// Rough per entry overhead of QHash and QList nodes, the numbers are estimates anyway
+static const qint64 s_hashNodeOverhead = 2 * sizeof(void *);
+
+QList<KStyle::MemoryUsage> KStyle::memoryUsage() const
+{
+    QList<MemoryUsage> usage;
+
+    qint64 elementBytes = 0;
+    for (auto it = d->styleElements.cbegin(); it != d->styleElements.cend(); ++it) {
+        elementBytes += sizeof(QString) + it.key().capacity() * sizeof(QChar) + sizeof(int) + s_hashNodeOverhead;
+    }
+    usage << MemoryUsage{QStringLiteral("customElements"), d->styleElements.size(), elementBytes};
+    usage << MemoryUsage{QStringLiteral("frameTimes"), d->frameTimes.size(), qint64(d->frameTimes.capacity() * sizeof(qint64))};
+    usage << MemoryUsage{QStringLiteral("cacheTrimmers"),
+                         d->cacheTrimmers.size() + d->memoryUsageReporters.size(),
+                         qint64(d->cacheTrimmers.capacity() * sizeof(std::function<qint64()>)
+                                + d->memoryUsageReporters.capacity() * sizeof(std::function<MemoryUsage()>))};
+
+    for (const auto &reporter : std::as_const(d->memoryUsageReporters)) {
+        usage << reporter();
+    }
+    return usage;
+}
+
+void KStyle::dumpMemoryUsage() const
+{
+    qint64 total = 0;
+    const QList<MemoryUsage> usage = memoryUsage();
+    for (const MemoryUsage &entry : usage) {
+        qCDebug(KSTYLE).nospace() << metaObject()->className() << " " << entry.name << ": " << entry.entries << " entries, " << entry.bytes << " bytes";
+        total += entry.bytes;
+    }
+    qCDebug(KSTYLE).nospace() << metaObject()->className() << " total: " << total << " bytes";
+}
+
+void KStyle::addMemoryUsageReporter(const std::function<MemoryUsage()> &reporter)
+{
+    d->memoryUsageReporters << reporter;
 }
 
 void KStyle::polish(QWidget *w)
 {
+    if (d->frameTimer && w->isWindow()) {
+        w->installEventFilter(d->frameTimer);
+    }
+
     // Enable hover effects in all itemviews
     if (QAbstractItemView *itemView = qobject_cast<QAbstractItemView *>(w)) {
         itemView->viewport()->setAttribute(Qt::WA_Hover);
     }
 
-    if (QDialogButtonBox *box = qobject_cast<QDialogButtonBox *>(w)) {
-        QPushButton *button = box->button(QDialogButtonBox::Ok);
+    // Widgets which are never shown, e.g. on pages the user doesn't visit, never pay for the rest
+    if (d->deferredPolish && w->window()->isVisible() && !w->isVisibleTo(w->window())) {
+        w->installEventFilter(d->deferredPolish);
+    } else {
+        d->polishExpensive(w);
+    }
+    QCommonStyle::polish(w);
+}
 
-        if (button) {
-            auto shortcut = new QShortcut(Qt::CTRL | Qt::Key_Return, button);
-            QObject::connect(shortcut, &QShortcut::activated, button, &QPushButton::click);
-        }
+void KStyle::unpolish(QWidget *w)
+{
+    if (d->frameTimer) {
+        w->removeEventFilter(d->frameTimer);
     }
-    if (auto messageWidget = qobject_cast<KMessageWidget *>(w)) {
-        KColorScheme scheme;
-        QColor color;
-        QPalette palette = messageWidget->palette();
-        switch (messageWidget->messageType()) {
-        case KMessageWidget::Positive:
-            color = scheme.foreground(KColorScheme::PositiveText).color();
-            break;
-        case KMessageWidget::Information:
-            color = scheme.foreground(KColorScheme::ActiveText).color();
-            break;
-        case KMessageWidget::Warning:
-            color = scheme.foreground(KColorScheme::NeutralText).color();
-            break;
-        case KMessageWidget::Error:
-            color = scheme.foreground(KColorScheme::NegativeText).color();
-            break;
-        }
-        palette.setColor(QPalette::Window, color);
-        messageWidget->setPalette(palette);
+    if (d->deferredPolish) {
+        w->removeEventFilter(d->deferredPolish);
     }
-    QCommonStyle::polish(w);
+    if (QAbstractItemView *itemView = qobject_cast<QAbstractItemView *>(w)) {
+        delete itemView->viewport()->findChild<QObject *>(QStringLiteral("KStyleHoverThrottle"), Qt::FindDirectChildrenOnly);
+    }
+    QCommonStyle::unpolish(w);
 }
 
 QPalette KStyle::standardPalette() const
@@ -249,11 +1043,11 @@ QIcon KStyle::standardIcon(StandardPixmap standardIcon, const QStyleOption *opti
     case QStyle::SP_DirIcon:
         return QIcon::fromTheme(QStringLiteral("folder"));
     case QStyle::SP_DirLinkIcon:
-        return QIcon::fromTheme(QStringLiteral("folder")); // TODO: generate (!?) folder with link emblem
+        return d->iconCache->emblemIcon(QStringLiteral("folder"), QStringLiteral("emblem-symbolic-link"));
     case QStyle::SP_FileIcon:
         return QIcon::fromTheme(QStringLiteral("text-plain")); // TODO: look for a better icon
     case QStyle::SP_FileLinkIcon:
-        return QIcon::fromTheme(QStringLiteral("text-plain")); // TODO: generate (!?) file with link emblem
+        return d->iconCache->emblemIcon(QStringLiteral("text-plain"), QStringLiteral("emblem-symbolic-link"));
     case QStyle::SP_FileDialogStart:
         return QIcon::fromTheme(QStringLiteral("media-playback-start")); // TODO: find correct icon
     case QStyle::SP_FileDialogEnd:
@@ -368,27 +1162,27 @@ QIcon KStyle::standardIcon(StandardPixmap standardIcon, const QStyleOption *opti
 
 int KStyle::styleHint(StyleHint hint, const QStyleOption *option, const QWidget *widget, QStyleHintReturn *returnData) const
 {
+    // Within queryStyle() all hints are answered from the settings it read once
+    const KStyleSettings *settings = d->querySettings;
+
     switch (hint) {
-    case SH_DialogButtonBox_ButtonsHaveIcons: {
+    case SH_DialogButtonBox_ButtonsHaveIcons:
         // was KGlobalSettings::showIconsOnPushButtons() :
-        KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE"));
-        return g.readEntry("ShowIconsOnPushButtons", true);
-    }
+        return settings ? settings->showIconsOnPushButtons : KStyleSettings::readShowIconsOnPushButtons(KSharedConfig::openConfig());
 
     case SH_ItemView_ArrowKeysNavigateIntoChildren:
         return true;
 
-    case SH_Widget_Animate: {
-        KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE-Global GUI Settings"));
-        return g.readEntry("GraphicEffectsLevel", true);
-    }
+    case SH_Widget_Animate:
+        if (d->animationQuality == NoAnimations) {
+            return false;
+        }
+        return settings ? settings->graphicEffects : KStyleSettings::readGraphicEffects(KSharedConfig::openConfig());
 
     case QStyle::SH_Menu_SubMenuSloppyCloseTimeout:
         return 300;
 
     case SH_ToolButtonStyle: {
-        KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("Toolbar style"));
-
         bool useOthertoolbars = false;
         const QWidget *parent = widget ? widget->parentWidget() : nullptr;
 
@@ -399,19 +1193,10 @@ int KStyle::styleHint(StyleHint hint, const QStyleOption *option, const QWidget
             }
         }
 
-        QString buttonStyle;
-        if (useOthertoolbars) {
-            buttonStyle = g.readEntry("ToolButtonStyleOtherToolbars", "NoText").toLower();
-        } else {
-            buttonStyle = g.readEntry("ToolButtonStyle", "TextBesideIcon").toLower();
+        if (settings) {
+            return useOthertoolbars ? settings->toolButtonStyleOtherToolbars : settings->toolButtonStyle;
         }
-
-        return buttonStyle == QLatin1String("textbesideicon") ? Qt::ToolButtonTextBesideIcon
-            : buttonStyle == QLatin1String("icontextright")   ? Qt::ToolButtonTextBesideIcon
-            : buttonStyle == QLatin1String("textundericon")   ? Qt::ToolButtonTextUnderIcon
-            : buttonStyle == QLatin1String("icontextbottom")  ? Qt::ToolButtonTextUnderIcon
-            : buttonStyle == QLatin1String("textonly")        ? Qt::ToolButtonTextOnly
-                                                              : Qt::ToolButtonIconOnly;
+        return KStyleSettings::readToolButtonStyle(KSharedConfig::openConfig(), useOthertoolbars);
     }
 
     case SH_KCustomStyleElement:
@@ -421,10 +1206,8 @@ int KStyle::styleHint(StyleHint hint, const QStyleOption *option, const QWidget
 
         return d->styleElements.value(widget->objectName(), 0);
 
-    case SH_ScrollBar_LeftClickAbsolutePosition: {
-        KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE"));
-        return !g.readEntry("ScrollbarLeftClickNavigatesByPage", false);
-    }
+    case SH_ScrollBar_LeftClickAbsolutePosition:
+        return settings ? settings->leftClickAbsolutePosition : KStyleSettings::readLeftClickAbsolutePosition(KSharedConfig::openConfig());
 
     default:
         break;
@@ -433,6 +1216,78 @@ int KStyle::styleHint(StyleHint hint, const QStyleOption *option, const QWidget
     return QCommonStyle::styleHint(hint, option, widget, returnData);
 }
 
+KStyle::StyleValues KStyle::queryStyle(const QList<StyleHint> &hints, const QList<PixelMetric> &metrics, const QStyleOption *option, const QWidget *widget) const
+{
+    // Nested queries, e.g. from a derived styleHint(), keep using the outer snapshot
+    std::optional<KStyleSettings> settings;
+    if (!d->querySettings && !hints.isEmpty()) {
+        settings = KStyleSettings::read();
+        d->querySettings = &*settings;
+    }
+
+    StyleValues values;
+    values.hints.reserve(hints.size());
+    for (StyleHint hint : hints) {
+        // Virtual, so that derived styles answer the hints they reimplement
+        values.hints << styleHint(hint, option, widget, nullptr);
+    }
+    values.metrics.reserve(metrics.size());
+    for (PixelMetric metric : metrics) {
+        values.metrics << pixelMetric(metric, option, widget);
+    }
+
+    if (settings) {
+        d->querySettings = nullptr;
+    }
+    return values;
+}
+
+QPixmap KStyle::cachedTile(const QString &element,
+                           const QStyleOption *option,
+                           const QSize &size,
+                           qreal devicePixelRatio,
+                           const std::function<void(QPainter *)> &render) const
+{
+    if (size.isEmpty() || devicePixelRatio <= 0) {
+        return QPixmap();
+    }
+
+    const KStyleTileKey key{element,
+                            option ? int(option->state.toInt()) : int(State_None),
+                            option ? int(option->direction) : int(Qt::LeftToRight),
+                            option ? option->palette.cacheKey() : 0,
+                            size,
+                            devicePixelRatio};
+    if (const QPixmap *tile = d->tileCache.object(key)) {
+        ++d->tileHits;
+        return *tile;
+    }
+    ++d->tileMisses;
+
+    QPixmap tile((QSizeF(size) * devicePixelRatio).toSize());
+    tile.setDevicePixelRatio(devicePixelRatio);
+    tile.fill(Qt::transparent);
+    {
+        QPainter painter(&tile);
+        render(&painter);
+    }
+
+    // Tiles larger than the whole cache are dropped right away by QCache
+    const qint64 bytes = qint64(tile.width()) * tile.height() * tile.depth() / 8;
+    d->tileCache.insert(key, new QPixmap(tile), bytes);
+    return tile;
+}
+
+KStyle::TileCacheStatistics KStyle::tileCacheStatistics() const
+{
+    return TileCacheStatistics{d->tileHits, d->tileMisses, d->tileCache.size(), d->tileCache.totalCost(), d->tileCache.maxCost()};
+}
+
+void KStyle::setTileCacheLimit(qint64 bytes)
+{
+    d->tileCache.setMaxCost(qMax<qint64>(0, bytes));
+}
+
 int KStyle::pixelMetric(PixelMetric metric, const QStyleOption *option, const QWidget *widget) const
 {
     switch (metric) {
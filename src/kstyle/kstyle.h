@@ -34,6 +34,9 @@
 
 #include <QCommonStyle>
 #include <QPalette>
+#include <QPixmap>
+
+#include <functional>
 
 class KStylePrivate;
 
@@ -48,6 +51,11 @@ class KStylePrivate;
  * consistent user experience. For example, this will ensure a
  * consistent single-click or double-click activation setting,
  * and the use of standard themed icons.
+ *
+ * Setting DeferredPolish to true in the "KDE-Global GUI Settings" group of
+ * kdeglobals makes polish() postpone the costly part of its work for widgets
+ * hidden in an already shown window, e.g. on the pages of a tab widget, until
+ * they are first shown.
  */
 class KSTYLE_EXPORT KStyle : public QCommonStyle
 {
@@ -57,6 +65,220 @@ public:
     KStyle();
     ~KStyle() override;
 
+    /*!
+     * \enum KStyle::AnimationQuality
+     *
+     * How much animation the application can afford, see animationQuality().
+     *
+     * \value FullAnimations
+     *        Frames are painted within their budget.
+     * \value ReducedAnimations
+     *        Frames go over their budget, styles should use shorter or simpler animations.
+     * \value NoAnimations
+     *        Frames go far over their budget, SH_Widget_Animate is turned off.
+     *
+     * \since 6.30
+     */
+    enum AnimationQuality {
+        FullAnimations,
+        ReducedAnimations,
+        NoAnimations,
+    };
+    Q_ENUM(AnimationQuality)
+
+    /*!
+     * Returns how much animation the application can currently afford.
+     *
+     * This is always FullAnimations unless AdaptiveAnimations is enabled in the
+     * "KDE-Global GUI Settings" group of kdeglobals. In that case KStyle measures how
+     * long the windows using this style take to paint a frame and compares the average
+     * of the last AnimationFrameWindow frames with the frame budget:
+     *
+     * \list
+     * \li AnimationFrameBudget: the budget in milliseconds, defaults to the refresh interval of the primary screen
+     * \li AnimationReduceThreshold: above this percentage of the budget animations are reduced (default 100)
+     * \li AnimationDisableThreshold: above this percentage of the budget animations are turned off (default 200)
+     * \li AnimationRecoverThreshold: below this percentage of the budget the quality goes up one step again (default 50)
+     * \li AnimationFrameWindow: the number of frames averaged (default 30)
+     * \endlist
+     *
+     * The settings are read when the style is created.
+     *
+     * \since 6.30
+     */
+    AnimationQuality animationQuality() const;
+
+    /*!
+     * Adds the time it took to paint a frame to the adaptive animation measurement.
+     *
+     * KStyle measures the frames of its widget windows itself, this is meant for frames
+     * painted elsewhere, e.g. by a QtQuick scene in the same application.
+     * Ignored unless AdaptiveAnimations is enabled.
+     *
+     * \a microseconds The time it took to paint the frame
+     *
+     * \since 6.30
+     */
+    void reportFrameTime(qint64 microseconds);
+
+    /*!
+     * Drops all caches of the style that can be rebuilt on demand, including the ones
+     * registered by derived styles with addCacheTrimmer().
+     *
+     * With TrimCachesOnMemoryPressure set to true in the "KDE-Global GUI Settings" group
+     * of kdeglobals, this happens automatically when Linux reports memory pressure, i.e.
+     * when tasks stalled on memory for more than MemoryPressureThreshold percent of the
+     * time (default 10) according to /proc/pressure/memory. This needs a kernel which
+     * allows unprivileged processes to register a pressure trigger, otherwise caches are
+     * only trimmed on request.
+     *
+     * Returns the number of bytes released.
+     *
+     * \since 6.30
+     */
+    qint64 trimCaches();
+
+    /*!
+     * \class KStyle::MemoryUsage
+     * \inmodule KStyle
+     *
+     * \brief The estimated size of one internal structure of the style.
+     *
+     * \since 6.30
+     */
+    struct MemoryUsage {
+        /*!
+         * The name of the structure, e.g. "customElements"
+         */
+        QString name;
+        /*!
+         * The number of entries held
+         */
+        qint64 entries = 0;
+        /*!
+         * The estimated number of bytes used by the entries
+         */
+        qint64 bytes = 0;
+    };
+
+    /*!
+     * Returns the estimated memory usage of the internal structures of the style,
+     * including the ones registered by derived styles with addMemoryUsageReporter().
+     *
+     * \since 6.30
+     */
+    QList<MemoryUsage> memoryUsage() const;
+
+    /*!
+     * Prints memoryUsage() and its total to the kf.style logging category.
+     *
+     * While debug output of kf.style is enabled when the style is created, this also
+     * happens every KSTYLE_MEMORY_DUMP_INTERVAL seconds (default 60) and after every
+     * trimCaches(), so that a long running process can be watched.
+     *
+     * \since 6.30
+     */
+    void dumpMemoryUsage() const;
+
+    /*!
+     * \class KStyle::StyleValues
+     * \inmodule KStyle
+     *
+     * \brief The answers of queryStyle(), in the order of the query.
+     *
+     * \since 6.30
+     */
+    struct StyleValues {
+        /*!
+         * The values of the queried style hints
+         */
+        QList<int> hints;
+        /*!
+         * The values of the queried pixel metrics
+         */
+        QList<int> metrics;
+    };
+
+    /*!
+     * Answers several style hints and pixel metrics for the same \a option and \a widget at once.
+     *
+     * The result is the same as calling styleHint() and pixelMetric() for each of
+     * \a hints and \a metrics, including the answers of derived styles, but the
+     * KDE settings the hints depend on are read only once for the whole query.
+     * Meant for widgets which need a lot of hints during construction or relayout.
+     *
+     * \since 6.30
+     */
+    StyleValues queryStyle(const QList<StyleHint> &hints,
+                           const QList<PixelMetric> &metrics,
+                           const QStyleOption *option = nullptr,
+                           const QWidget *widget = nullptr) const;
+
+    /*!
+     * \class KStyle::TileCacheStatistics
+     * \inmodule KStyle
+     *
+     * \brief The state of the tile cache used by cachedTile().
+     *
+     * \since 6.30
+     */
+    struct TileCacheStatistics {
+        /*!
+         * The number of tiles that were served from the cache
+         */
+        qint64 hits = 0;
+        /*!
+         * The number of tiles that had to be rendered
+         */
+        qint64 misses = 0;
+        /*!
+         * The number of cached tiles
+         */
+        qint64 entries = 0;
+        /*!
+         * The size of the cached tiles in bytes
+         */
+        qint64 bytes = 0;
+        /*!
+         * The size the cache is limited to in bytes
+         */
+        qint64 maxBytes = 0;
+    };
+
+    /*!
+     * Returns the hit and miss counts and the size of the tile cache, e.g. to measure
+     * how well the tiles of a derived style are reused.
+     *
+     * \since 6.30
+     */
+    TileCacheStatistics tileCacheStatistics() const;
+
+    /*!
+     * Limits the tile cache to \a bytes, the least recently used tiles are dropped first.
+     *
+     * Defaults to the TileCacheSize entry (in KiB) of the "KDE-Global GUI Settings"
+     * group in kdeglobals, or 8 MiB.
+     *
+     * \since 6.30
+     */
+    void setTileCacheLimit(qint64 bytes);
+
+Q_SIGNALS:
+    /*!
+     * Emitted when the adaptive animation measurement changed animationQuality() to \a quality
+     *
+     * \since 6.30
+     */
+    void animationQualityChanged(KStyle::AnimationQuality quality);
+
+    /*!
+     * Emitted after trimCaches() released \a bytes
+     *
+     * \since 6.30
+     */
+    void cachesTrimmed(qint64 bytes);
+
+public:
     /*!
      * Runtime element extension
      * This is just convenience and does /not/ require the using widgets style to inherit KStyle
@@ -87,6 +309,10 @@ public:
      *
      * 3) If you cache this value (good idea, this requires a map lookup) don't (!) forget to catch
      * style changes in QWidget::changeEvent()
+     *
+     * Since 6.30 the id only depends on the \a element string, so a cached id stays valid across
+     * style reloads and changes; on a style change it is enough to check whether the new style
+     * still supports the element, i.e. the call doesn't return 0.
      */
     static StyleHint customStyleHint(const QString &element, const QWidget *widget);
 
@@ -130,6 +356,10 @@ protected:
      * request will be ignored (return is 0)
      * 2) To keep UI coherency, don't support any nonsense in your style, but convince app developers
      * to use standard elements - if available
+     * 3) Since 6.30 the returned id is derived from \a element, every style instance returns the same
+     * id for the same string. That only holds as long as the id doesn't collide with the one of
+     * another element of the style, which is unlikely but then makes the id depend on the
+     * registration order; a warning is printed in that case
      */
     StyleHint newStyleHint(const QString &element);
 
@@ -143,6 +373,45 @@ protected:
      */
     SubElement newSubElement(const QString &element);
 
+    /*!
+     * Registers a cache of a derived style with trimCaches().
+     *
+     * \a trimmer Drops the cache and returns the number of bytes it released
+     *
+     * \since 6.30
+     */
+    void addCacheTrimmer(const std::function<qint64()> &trimmer);
+
+    /*!
+     * Registers a structure of a derived style with memoryUsage().
+     *
+     * \a reporter Returns the current usage of the structure
+     *
+     * \since 6.30
+     */
+    void addMemoryUsageReporter(const std::function<MemoryUsage()> &reporter);
+
+    /*!
+     * Returns a tile of \a size logical pixels at \a devicePixelRatio, rendered by
+     * \a render onto a transparent pixmap if it isn't cached yet.
+     *
+     * Tiles are shared by all widgets and identified by \a element together with the
+     * state, layout direction and palette of \a option, so that frames, gradients or
+     * shadows rendered for one widget are reused for all others looking the same.
+     * Anything else the rendering depends on has to be part of \a element.
+     *
+     * The cache takes part in trimCaches() and memoryUsage().
+     *
+     * \sa tileCacheStatistics(), setTileCacheLimit()
+     *
+     * \since 6.30
+     */
+    QPixmap cachedTile(const QString &element,
+                       const QStyleOption *option,
+                       const QSize &size,
+                       qreal devicePixelRatio,
+                       const std::function<void(QPainter *)> &render) const;
+
 public:
     int pixelMetric(PixelMetric m, const QStyleOption *opt = nullptr, const QWidget *widget = nullptr) const override;
     int styleHint(StyleHint hint, const QStyleOption *opt, const QWidget *w, QStyleHintReturn *returnData) const override;
@@ -150,6 +419,9 @@ public:
     void polish(QWidget *) override;
     using QCommonStyle::polish; // needed to avoid warnings at compilation time
 
+    void unpolish(QWidget *) override;
+    using QCommonStyle::unpolish;
+
     QPalette standardPalette() const override;
 
     QIcon standardIcon(StandardPixmap standardIcon, const QStyleOption *option = nullptr, const QWidget *widget = nullptr) const override;
@@ -0,0 +1,259 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+/*
+    Renders a gallery of typical widgets with KStyle, or a style derived from it, on the
+    offscreen platform and prints the polish and per frame render times as JSON, one line
+    per gallery page:
+
+    kstylegallerybenchmark [--style breeze] [--frames 200] [--scale 2]
+*/
+
+#include "kstyle.h"
+
+#include <KMessageWidget>
+
+#include <QAction>
+#include <QApplication>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QElapsedTimer>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QMainWindow>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QRadioButton>
+#include <QSlider>
+#include <QSpinBox>
+#include <QStyleFactory>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QTextEdit>
+#include <QToolBar>
+#include <QToolButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <memory>
+
+static QWidget *createToolBars()
+{
+    auto window = new QMainWindow;
+    const QList<Qt::ToolButtonStyle> buttonStyles = {Qt::ToolButtonIconOnly, Qt::ToolButtonTextBesideIcon, Qt::ToolButtonTextUnderIcon};
+    for (Qt::ToolButtonStyle buttonStyle : buttonStyles) {
+        QToolBar *toolBar = window->addToolBar(QStringLiteral("Toolbar"));
+        toolBar->setToolButtonStyle(buttonStyle);
+        const QStringList icons = {QStringLiteral("document-new"), QStringLiteral("document-open"), QStringLiteral("document-save"), QStringLiteral("edit-undo")};
+        for (const QString &icon : icons) {
+            toolBar->addAction(QIcon::fromTheme(icon), icon);
+        }
+        toolBar->addSeparator();
+        auto menuButton = new QToolButton(toolBar);
+        menuButton->setText(QStringLiteral("Menu"));
+        menuButton->setPopupMode(QToolButton::MenuButtonPopup);
+        menuButton->addAction(new QAction(QStringLiteral("Entry"), menuButton));
+        toolBar->addWidget(menuButton);
+        window->addToolBarBreak();
+    }
+    window->setCentralWidget(new QTextEdit(QStringLiteral("Some text below the toolbars")));
+    window->resize(800, 300);
+    return window;
+}
+
+static QWidget *createItemViews()
+{
+    auto page = new QWidget;
+    auto layout = new QHBoxLayout(page);
+
+    auto tree = new QTreeWidget;
+    tree->setHeaderLabels({QStringLiteral("Name"), QStringLiteral("Size"), QStringLiteral("Type")});
+    for (int i = 0; i < 20; ++i) {
+        auto parent = new QTreeWidgetItem(tree, {QStringLiteral("Folder %1").arg(i), QString(), QStringLiteral("Folder")});
+        parent->setIcon(0, QIcon::fromTheme(QStringLiteral("folder")));
+        for (int j = 0; j < 5; ++j) {
+            new QTreeWidgetItem(parent, {QStringLiteral("File %1").arg(j), QStringLiteral("%1 KiB").arg(j * 17), QStringLiteral("Text")});
+        }
+    }
+    tree->expandAll();
+    tree->setAlternatingRowColors(true);
+    layout->addWidget(tree);
+
+    auto table = new QTableWidget(50, 6);
+    for (int row = 0; row < table->rowCount(); ++row) {
+        for (int column = 0; column < table->columnCount(); ++column) {
+            table->setItem(row, column, new QTableWidgetItem(QStringLiteral("%1, %2").arg(row).arg(column)));
+        }
+    }
+    table->selectRow(3);
+    layout->addWidget(table);
+
+    auto list = new QListWidget;
+    list->setViewMode(QListView::IconMode);
+    for (int i = 0; i < 40; ++i) {
+        list->addItem(new QListWidgetItem(QIcon::fromTheme(QStringLiteral("text-plain")), QStringLiteral("Item %1").arg(i)));
+    }
+    layout->addWidget(list);
+
+    page->resize(1200, 600);
+    return page;
+}
+
+static QWidget *createMessageWidgets()
+{
+    auto page = new QWidget;
+    auto layout = new QVBoxLayout(page);
+    const QList<KMessageWidget::MessageType> types = {KMessageWidget::Positive, KMessageWidget::Information, KMessageWidget::Warning, KMessageWidget::Error};
+    for (KMessageWidget::MessageType type : types) {
+        auto message = new KMessageWidget(QStringLiteral("A message which is long enough to be wrapped when the widget gets narrow"));
+        message->setMessageType(type);
+        message->setWordWrap(true);
+        message->addAction(new QAction(QStringLiteral("Action"), message));
+        layout->addWidget(message);
+    }
+    layout->addStretch();
+    page->resize(600, 400);
+    return page;
+}
+
+static QWidget *createDialog()
+{
+    auto dialog = new QDialog;
+    auto layout = new QVBoxLayout(dialog);
+
+    auto tabs = new QTabWidget;
+    auto form = new QWidget;
+    auto formLayout = new QFormLayout(form);
+    formLayout->addRow(QStringLiteral("Name:"), new QLineEdit(QStringLiteral("Konqi")));
+    auto combo = new QComboBox;
+    combo->addItems({QStringLiteral("One"), QStringLiteral("Two"), QStringLiteral("Three")});
+    formLayout->addRow(QStringLiteral("Choice:"), combo);
+    formLayout->addRow(QStringLiteral("Count:"), new QSpinBox);
+    auto slider = new QSlider(Qt::Horizontal);
+    slider->setValue(40);
+    formLayout->addRow(QStringLiteral("Level:"), slider);
+    auto progress = new QProgressBar;
+    progress->setValue(60);
+    formLayout->addRow(QStringLiteral("Progress:"), progress);
+    tabs->addTab(form, QStringLiteral("General"));
+    tabs->addTab(new QWidget, QStringLiteral("Advanced"));
+    layout->addWidget(tabs);
+
+    auto group = new QGroupBox(QStringLiteral("Options"));
+    auto groupLayout = new QVBoxLayout(group);
+    groupLayout->addWidget(new QCheckBox(QStringLiteral("Check me")));
+    auto radio = new QRadioButton(QStringLiteral("Pick me"));
+    radio->setChecked(true);
+    groupLayout->addWidget(radio);
+    layout->addWidget(group);
+
+    layout->addWidget(new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel | QDialogButtonBox::Help));
+    dialog->resize(500, 450);
+    return dialog;
+}
+
+static void printJson(const QJsonObject &object)
+{
+    const QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    std::fprintf(stdout, "%s\n", line.constData());
+    std::fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    // Rendering into images doesn't need a display, and the offscreen platform keeps the numbers comparable
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption styleOption(QStringLiteral("style"), QStringLiteral("Style to benchmark instead of plain KStyle"), QStringLiteral("key"));
+    parser.addOption(styleOption);
+    QCommandLineOption framesOption(QStringLiteral("frames"), QStringLiteral("Frames to render per page"), QStringLiteral("count"), QStringLiteral("100"));
+    parser.addOption(framesOption);
+    QCommandLineOption scaleOption(QStringLiteral("scale"), QStringLiteral("Device pixel ratio to render at"), QStringLiteral("ratio"), QStringLiteral("1"));
+    parser.addOption(scaleOption);
+    parser.process(app);
+
+    QStyle *style = parser.isSet(styleOption) ? QStyleFactory::create(parser.value(styleOption)) : new KStyle;
+    if (!style) {
+        qWarning() << "unknown style" << parser.value(styleOption);
+        return 1;
+    }
+    app.setStyle(style);
+    const int frames = std::max(1, parser.value(framesOption).toInt());
+    const qreal scale = std::max(0.5, parser.value(scaleOption).toDouble());
+
+    const QList<std::pair<QString, std::function<QWidget *()>>> pages = {
+        {QStringLiteral("toolbars"), createToolBars},
+        {QStringLiteral("itemviews"), createItemViews},
+        {QStringLiteral("messagewidgets"), createMessageWidgets},
+        {QStringLiteral("dialog"), createDialog},
+    };
+
+    for (const auto &[name, create] : pages) {
+        std::unique_ptr<QWidget> page(create());
+
+        QElapsedTimer timer;
+        timer.start();
+        page->ensurePolished();
+        // Polishes the children and lays them out, like showing the page would
+        page->adjustSize();
+        page->resize(page->size().expandedTo(page->sizeHint()));
+        const qint64 polishNsecs = timer.nsecsElapsed();
+
+        QImage image(page->size() * scale, QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(scale);
+        QList<qint64> frameNsecs;
+        frameNsecs.reserve(frames);
+        for (int i = 0; i < frames; ++i) {
+            image.fill(Qt::transparent);
+            timer.restart();
+            page->render(&image);
+            frameNsecs << timer.nsecsElapsed();
+        }
+        std::sort(frameNsecs.begin(), frameNsecs.end());
+        qint64 totalNsecs = 0;
+        for (qint64 nsecs : std::as_const(frameNsecs)) {
+            totalNsecs += nsecs;
+        }
+
+        const auto msecs = [](qint64 nsecs) {
+            return nsecs / 1000000.0;
+        };
+        printJson({
+            {QStringLiteral("style"), style->name()},
+            {QStringLiteral("kstyle"), qobject_cast<KStyle *>(style) != nullptr},
+            {QStringLiteral("page"), name},
+            {QStringLiteral("width"), page->width()},
+            {QStringLiteral("height"), page->height()},
+            {QStringLiteral("scale"), scale},
+            {QStringLiteral("polishMs"), msecs(polishNsecs)},
+            {QStringLiteral("frames"), frames},
+            {QStringLiteral("frameMsMin"), msecs(frameNsecs.constFirst())},
+            {QStringLiteral("frameMsMedian"), msecs(frameNsecs.at(frameNsecs.size() / 2))},
+            {QStringLiteral("frameMsP95"), msecs(frameNsecs.at(frameNsecs.size() * 95 / 100))},
+            {QStringLiteral("frameMsMax"), msecs(frameNsecs.constLast())},
+            {QStringLiteral("frameMsMean"), msecs(totalNsecs / frames)},
+        });
+    }
+    return 0;
+}
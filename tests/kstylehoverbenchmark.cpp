@@ -0,0 +1,139 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "kstyle.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QAbstractTableModel>
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QHeaderView>
+#include <QHoverEvent>
+#include <QPaintEvent>
+#include <QStandardPaths>
+#include <QTableView>
+#include <QTest>
+
+static void prepareEnvironment()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+Q_COREAPP_STARTUP_FUNCTION(prepareEnvironment)
+
+// A model far too large to keep around, its cells are generated on demand and counted
+class LargeModel : public QAbstractTableModel
+{
+public:
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : 1000000;
+    }
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : 12;
+    }
+    QVariant data(const QModelIndex &index, int role) const override
+    {
+        if (role != Qt::DisplayRole) {
+            return QVariant();
+        }
+        ++dataCalls;
+        return QStringLiteral("%1:%2").arg(index.row()).arg(index.column());
+    }
+
+    mutable qint64 dataCalls = 0;
+};
+
+class PaintCounter : public QObject
+{
+public:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint) {
+            ++paintEvents;
+            for (const QRect &rect : static_cast<QPaintEvent *>(event)->region()) {
+                paintedPixels += qint64(rect.width()) * rect.height();
+            }
+        }
+        return QObject::eventFilter(watched, event);
+    }
+
+    qint64 paintEvents = 0;
+    qint64 paintedPixels = 0;
+};
+
+class KStyle_HoverBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchmarkHoverSweep_data()
+    {
+        QTest::addColumn<bool>("coalesced");
+        QTest::newRow("plain") << false;
+        QTest::newRow("coalesced") << true;
+    }
+
+    // Sweeps the pointer diagonally across a large table, with a move every millisecond like a high rate mouse
+    void benchmarkHoverSweep()
+    {
+        QFETCH(bool, coalesced);
+        KConfigGroup g(KSharedConfig::openConfig(), QStringLiteral("KDE-Global GUI Settings"));
+        g.writeEntry("CoalescedItemViewHover", coalesced);
+
+        KStyle style;
+        LargeModel model;
+        QTableView view;
+        view.setStyle(&style);
+        view.setModel(&model);
+        view.verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+        view.resize(1000, 800);
+        view.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&view));
+
+        QWidget *viewport = view.viewport();
+        PaintCounter counter;
+        viewport->installEventFilter(&counter);
+        model.dataCalls = 0;
+
+        const QSize size = viewport->size();
+        const int steps = 500;
+        QPointF lastPosition(-1, -1);
+        QElapsedTimer timer;
+        timer.start();
+        QHoverEvent enter(QEvent::HoverEnter, QPointF(0, 0), viewport->mapToGlobal(QPointF(0, 0)), lastPosition);
+        QCoreApplication::sendEvent(viewport, &enter);
+        for (int i = 0; i < steps; ++i) {
+            const QPointF position(size.width() * i / steps, size.height() * i / steps);
+            QHoverEvent move(QEvent::HoverMove, position, viewport->mapToGlobal(position), lastPosition);
+            QCoreApplication::sendEvent(viewport, &move);
+            lastPosition = position;
+            QTest::qWait(1);
+        }
+        QHoverEvent leave(QEvent::HoverLeave, QPointF(-1, -1), QPointF(-1, -1), lastPosition);
+        QCoreApplication::sendEvent(viewport, &leave);
+        QTest::qWait(50);
+        const qint64 elapsed = timer.elapsed();
+
+        qInfo().noquote() << QStringLiteral("hover sweep %1: %2 moves in %3 ms, %4 paint events, %5 pixels painted, %6 data() calls")
+                                 .arg(QLatin1String(QTest::currentDataTag()))
+                                 .arg(steps)
+                                 .arg(elapsed)
+                                 .arg(counter.paintEvents)
+                                 .arg(counter.paintedPixels)
+                                 .arg(model.dataCalls);
+        QVERIFY(counter.paintEvents > 0);
+
+        g.revertToDefault("CoalescedItemViewHover");
+    }
+};
+
+QTEST_MAIN(KStyle_HoverBenchmark)
+
+#include "kstylehoverbenchmark.moc"
@@ -0,0 +1,96 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 KDE Contributors
+
+    SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "kstyle.h"
+
+#include <QApplication>
+#include <QStandardPaths>
+#include <QTest>
+#include <QToolBar>
+#include <QToolButton>
+
+static void prepareEnvironment()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+Q_COREAPP_STARTUP_FUNCTION(prepareEnvironment)
+
+// What a complex widget typically asks for while it is constructed
+static const QList<QStyle::StyleHint> s_hints = {
+    QStyle::SH_DialogButtonBox_ButtonsHaveIcons,
+    QStyle::SH_ToolButtonStyle,
+    QStyle::SH_ScrollBar_LeftClickAbsolutePosition,
+    QStyle::SH_Widget_Animate,
+    QStyle::SH_ItemView_ArrowKeysNavigateIntoChildren,
+    QStyle::SH_Menu_SubMenuSloppyCloseTimeout,
+    QStyle::SH_ToolButtonStyle,
+    QStyle::SH_Widget_Animate,
+    QStyle::SH_DialogButtonBox_ButtonsHaveIcons,
+    QStyle::SH_ScrollBar_LeftClickAbsolutePosition,
+    QStyle::SH_ItemView_ActivateItemOnSingleClick,
+    QStyle::SH_Menu_Scrollable,
+};
+static const QList<QStyle::PixelMetric> s_metrics = {
+    QStyle::PM_SmallIconSize,
+    QStyle::PM_ButtonIconSize,
+    QStyle::PM_ToolBarIconSize,
+    QStyle::PM_LargeIconSize,
+    QStyle::PM_DefaultFrameWidth,
+    QStyle::PM_LayoutHorizontalSpacing,
+    QStyle::PM_LayoutVerticalSpacing,
+    QStyle::PM_ScrollBarExtent,
+    QStyle::PM_ToolBarItemSpacing,
+    QStyle::PM_ButtonMargin,
+    QStyle::PM_FocusFrameHMargin,
+    QStyle::PM_MessageBoxIconSize,
+};
+
+class KStyle_QueryBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase()
+    {
+        m_style = new KStyle;
+        qApp->setStyle(m_style);
+        m_button = new QToolButton(&m_toolBar);
+    }
+
+    void benchmarkIndividualCalls()
+    {
+        int sum = 0;
+        QBENCHMARK {
+            for (QStyle::StyleHint hint : s_hints) {
+                sum += m_style->styleHint(hint, nullptr, m_button);
+            }
+            for (QStyle::PixelMetric metric : s_metrics) {
+                sum += m_style->pixelMetric(metric, nullptr, m_button);
+            }
+        }
+        QVERIFY(sum != 0);
+    }
+
+    void benchmarkQueryStyle()
+    {
+        int sum = 0;
+        QBENCHMARK {
+            const KStyle::StyleValues values = m_style->queryStyle(s_hints, s_metrics, nullptr, m_button);
+            sum += values.hints.constFirst() + values.metrics.constFirst();
+        }
+        QVERIFY(sum != 0);
+    }
+
+private:
+    KStyle *m_style = nullptr;
+    QToolBar m_toolBar;
+    QToolButton *m_button = nullptr;
+};
+
+QTEST_MAIN(KStyle_QueryBenchmark)
+
+#include "kstylequerybenchmark.moc"